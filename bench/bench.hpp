@@ -0,0 +1,81 @@
+#ifndef _PURRR_BENCH_HPP_
+#define _PURRR_BENCH_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+inline double now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline bool readFile(const char *filepath, std::vector<char> &content) {
+  std::ifstream file(filepath, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+  if (!file.is_open()) return false;
+
+  content.resize(file.tellg());
+  file.seekg(0);
+  file.read(content.data(), content.size());
+  return true;
+}
+
+class Results {
+public:
+  struct Field {
+    Field(const char *key, double value)
+      : key(key), value(value) {}
+    Field(const char *key, size_t value)
+      : key(key), value(static_cast<double>(value)) {}
+
+    const char *key;
+    double      value;
+  };
+
+  using Fields = std::vector<Field>;
+public:
+  void add(const char *name, const Fields &fields) { mEntries.emplace_back(name, fields); }
+  void skip(const char *name, const char *reason) { mSkipped.emplace_back(name, reason); }
+
+  void write(std::ostream &stream) const {
+    stream.precision(9);
+    stream << "{\n  \"results\": [";
+    for (size_t i = 0; i < mEntries.size(); ++i) {
+      stream << (i ? ",\n" : "\n") << "    { \"name\": \"" << mEntries[i].first << '"';
+      for (const Field &field : mEntries[i].second) stream << ", \"" << field.key << "\": " << field.value;
+      stream << " }";
+    }
+    stream << "\n  ],\n  \"skipped\": [";
+    for (size_t i = 0; i < mSkipped.size(); ++i)
+      stream << (i ? ",\n" : "\n") << "    { \"name\": \"" << mSkipped[i].first << "\", \"reason\": \""
+             << mSkipped[i].second << "\" }";
+    stream << "\n  ]\n}\n";
+  }
+
+  // Writes to stdout without a path, returns false if the file cannot be opened
+  bool write(const char *path) const {
+    if (!path) {
+      write(std::cout);
+      return true;
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open " << path << std::endl;
+      return false;
+    }
+    write(file);
+    return true;
+  }
+private:
+  std::vector<std::pair<const char *, Fields>>       mEntries = {};
+  std::vector<std::pair<const char *, const char *>> mSkipped = {};
+};
+
+} // namespace bench
+
+#endif // _PURRR_BENCH_HPP_
\ No newline at end of file
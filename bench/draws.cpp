@@ -0,0 +1,229 @@
+/*
+  Draw call stress benchmark
+
+  purrr_draw_bench [output.json] [--max-objects N] [--frames N]
+
+  Renders 1k to 1M small triangles into a headless render target through every submission path purrr exposes and
+  writes CPU and GPU milliseconds per frame and draws per second as JSON. The shaders next to this file have to be
+  compiled to SPIR-V in the working directory first:
+
+    dxc -spirv -T vs_6_0 -E main draws.vert.hlsl -Fo draws.vert.spv
+    dxc -spirv -T vs_6_0 -E main draws.instanced.vert.hlsl -Fo draws.instanced.vert.spv
+    dxc -spirv -T ps_6_0 -E main draws.frag.hlsl -Fo draws.frag.spv
+ */
+
+#include "purrr/purrr.hpp"
+#include "purrr/programBuilder.hpp"
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using bench::now;
+
+// Every Buffer owns a descriptor set and an allocation, objects share this many uniform buffers
+static constexpr size_t UNIFORM_POOL_SIZE = 256;
+// Timestamps arrive a few frames late, these frames keep the previous path out of the averages
+static constexpr size_t WARM_UP_FRAMES = 3;
+
+struct Transform {
+  float x, y, sx, sy;
+};
+
+// Spreads the objects over a grid covering the target
+static Transform objectTransform(size_t index, size_t count) {
+  size_t side = 1;
+  while (side * side < count) ++side;
+  float scale = 1.0f / static_cast<float>(side);
+
+  return { (static_cast<float>(index % side) * 2.0f + 1.0f) * scale - 1.0f,
+           (static_cast<float>(index / side) * 2.0f + 1.0f) * scale - 1.0f,
+           scale,
+           scale };
+}
+
+class Scene {
+public:
+  Scene(purrr::Context *context, size_t maxObjects, size_t frames)
+    : mContext(context), mFrames(frames) {
+    purrr::ImageInfo colorInfo{
+      1024, 1024, purrr::Format::RGBA8Unorm, purrr::ImageTiling::Optimal, { false, true, false, false }
+    };
+    colorInfo.name = "draw bench color";
+    mColor         = context->createImage(colorInfo);
+
+    purrr::RenderTargetInfo targetInfo{ 1024, 1024, &mColor, 1 };
+    targetInfo.name = "draw bench";
+    mTarget         = context->createRenderTarget(targetInfo);
+
+    for (size_t i = 0; i < UNIFORM_POOL_SIZE; ++i) {
+      Transform transform = objectTransform(i, UNIFORM_POOL_SIZE);
+      mUniforms.push_back(context->createBuffer({ purrr::BufferType::Uniform, sizeof(Transform) }));
+      mUniforms.back()->copy(&transform, 0, sizeof(Transform));
+    }
+
+    std::vector<Transform> transforms(maxObjects);
+    for (size_t i = 0; i < maxObjects; ++i) transforms[i] = objectTransform(i, maxObjects);
+    mInstances = context->createBuffer({ purrr::BufferType::Vertex, transforms.size() * sizeof(Transform) });
+    mInstances->copy(transforms.data(), 0, transforms.size() * sizeof(Transform));
+  }
+
+  ~Scene() {
+    delete mInstanced;
+    delete mUniform;
+    delete mInstances;
+    for (purrr::Buffer *buffer : mUniforms) delete buffer;
+    delete mTarget;
+    delete mColor;
+  }
+public:
+  bool loadPrograms() {
+    std::vector<char> vertexCode{}, instancedCode{}, fragmentCode{};
+    if (!bench::readFile("./draws.vert.spv", vertexCode) ||
+        !bench::readFile("./draws.instanced.vert.spv", instancedCode) ||
+        !bench::readFile("./draws.frag.spv", fragmentCode))
+      return false;
+
+    mUniform = purrr::ProgramBuilder()
+                   .addShader(mContext, purrr::ShaderType::Vertex, vertexCode)
+                   .addShader(mContext, purrr::ShaderType::Fragment, fragmentCode)
+                   .setCullMode(purrr::CullMode::Back)
+                   .setFrontFace(purrr::FrontFace::Clockwise)
+                   .setTopology(purrr::Topology::TriangleList)
+                   .addSlot(purrr::ProgramSlot::UniformBuffer)
+                   .build(mTarget);
+
+    mInstanced = purrr::ProgramBuilder()
+                     .addShader(mContext, purrr::ShaderType::Vertex, instancedCode)
+                     .addShader(mContext, purrr::ShaderType::Fragment, fragmentCode)
+                     .beginVertexInfo(sizeof(Transform), purrr::VertexInputRate::Instance)
+                     .addVertexAttrib(purrr::Format::RGBA32Sfloat, 0)
+                     .setCullMode(purrr::CullMode::Back)
+                     .setFrontFace(purrr::FrontFace::Clockwise)
+                     .setTopology(purrr::Topology::TriangleList)
+                     .build(mTarget);
+
+    return true;
+  }
+
+  // A bind and a draw per object, the closest purrr gets to per-object uniform buffers
+  void uniformPerObject(size_t objects) {
+    mContext->useProgram(mUniform);
+    for (size_t i = 0; i < objects; ++i) {
+      mContext->useUniformBuffer(mUniforms[i % UNIFORM_POOL_SIZE], 0);
+      mContext->draw(3);
+    }
+  }
+
+  // A draw per object without rebinding, the cost of the draw calls alone
+  void sharedUniform(size_t objects) {
+    mContext->useProgram(mUniform);
+    mContext->useUniformBuffer(mUniforms[0], 0);
+    for (size_t i = 0; i < objects; ++i) mContext->draw(3);
+  }
+
+  void instanced(size_t objects) {
+    mContext->useProgram(mInstanced);
+    mContext->useVertexBuffer(mInstances, 0);
+    mContext->draw(3, objects);
+  }
+public:
+  void measure(bench::Results &results, const char *path, size_t objects, void (Scene::*record)(size_t)) {
+    const std::vector<purrr::ContextClearValue> clearValues = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+    double cpu = 0.0, gpu = 0.0;
+    size_t gpuFrames = 0, draws = 0;
+    for (size_t frame = 0; frame < WARM_UP_FRAMES + mFrames; ++frame) {
+      mContext->begin();
+      double start = now();
+      mContext->record(mTarget, { clearValues });
+      (this->*record)(objects);
+      mContext->end();
+      mContext->submit();
+      double time = now() - start;
+
+      if (frame < WARM_UP_FRAMES) continue;
+      cpu   += time;
+      draws += mContext->getFrameStats().draws;
+
+      double frameGpu = 0.0;
+      for (const purrr::GpuTiming &timing : mContext->getGpuTimings())
+        if (timing.depth == 0) frameGpu += timing.milliseconds;
+      if (frameGpu > 0.0) {
+        gpu += frameGpu;
+        ++gpuFrames;
+      }
+    }
+    mContext->waitIdle();
+
+    bench::Results::Fields fields = { { "objects", objects },
+                                      { "frames", mFrames },
+                                      { "drawsPerFrame", draws / mFrames },
+                                      { "cpuMs", cpu * 1000.0 / mFrames },
+                                      { "drawsPerSecond", draws / cpu },
+                                      { "objectsPerSecond", objects * mFrames / cpu } };
+    // Queues without timestamps have nothing to report
+    if (gpuFrames > 0) fields.push_back({ "gpuMs", gpu / gpuFrames });
+    results.add(path, fields);
+  }
+private:
+  purrr::Context              *mContext   = nullptr;
+  size_t                       mFrames    = 0;
+  purrr::Image                *mColor     = nullptr;
+  purrr::RenderTarget         *mTarget    = nullptr;
+  std::vector<purrr::Buffer *> mUniforms  = {};
+  purrr::Buffer               *mInstances = nullptr;
+  purrr::Program              *mUniform   = nullptr;
+  purrr::Program              *mInstanced = nullptr;
+};
+
+int main(int argc, char **argv) {
+  const char *output     = nullptr;
+  size_t      maxObjects = 1'000'000;
+  size_t      frames     = 10;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--max-objects") == 0 && i + 1 < argc)
+      maxObjects = std::strtoull(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      frames = std::strtoull(argv[++i], nullptr, 10);
+    else
+      output = argv[i];
+  }
+  if (maxObjects == 0 || frames == 0) {
+    std::cerr << "--max-objects and --frames have to be positive" << std::endl;
+    return 1;
+  }
+
+  purrr::ContextInfo info{ purrr::Version(1, 1, 0), purrr::VERSION, "purrr" };
+  info.appName      = "purrr_draw_bench";
+  info.headless     = true;
+  info.gpuProfiling = true;
+
+  bench::Results  results{};
+  purrr::Context *context = purrr::Context::create(purrr::Api::Vulkan, info);
+
+  {
+    Scene scene(context, maxObjects, frames);
+    if (scene.loadPrograms()) {
+      for (size_t objects = 1'000; objects <= maxObjects; objects *= 10) {
+        scene.measure(results, "uniformPerObject", objects, &Scene::uniformPerObject);
+        scene.measure(results, "sharedUniform", objects, &Scene::sharedUniform);
+        scene.measure(results, "instanced", objects, &Scene::instanced);
+      }
+    } else {
+      for (const char *path : { "uniformPerObject", "sharedUniform", "instanced" })
+        results.skip(path, "draws.vert.spv, draws.instanced.vert.spv and draws.frag.spv not found");
+    }
+  }
+
+  // Not exposed by the purrr API yet, kept in the output so the comparison stays complete
+  for (const char *path : { "pushConstants", "dynamicOffsets", "indirect", "multiDrawIndirect" })
+    results.skip(path, "not supported by purrr");
+
+  delete context;
+
+  return results.write(output) ? 0 : 1;
+}
\ No newline at end of file
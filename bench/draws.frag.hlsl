@@ -0,0 +1,3 @@
+float4 main() : SV_TARGET0 {
+  return float4(1, 1, 1, 1);
+}
\ No newline at end of file
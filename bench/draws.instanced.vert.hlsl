@@ -0,0 +1,6 @@
+float4 main(uint vertexID : SV_VertexID,
+            [[vk::location(0)]] float4 transform : TRANSFORM) : SV_POSITION {
+  float2 positions[3] = {float2(0, -1), float2(1, 1), float2(-1, 1)};
+
+  return float4(positions[vertexID] * transform.zw + transform.xy, 0, 1);
+}
\ No newline at end of file
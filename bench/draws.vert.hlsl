@@ -0,0 +1,9 @@
+cbuffer Object : register(b0) {
+  float4 uTransform; // xy offset, zw scale
+};
+
+float4 main(uint vertexID : SV_VertexID) : SV_POSITION {
+  float2 positions[3] = {float2(0, -1), float2(1, 1), float2(-1, 1)};
+
+  return float4(positions[vertexID] * uTransform.zw + uTransform.xy, 0, 1);
+}
\ No newline at end of file
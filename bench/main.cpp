@@ -0,0 +1,307 @@
+/*
+  Microbenchmarks of the Vulkan backend
+
+  purrr_bench [output.json] [--window]
+
+  Results are written as JSON to the given file or stdout. Everything but swapchain recreation runs headless, so the
+  suite works on software drivers like lavapipe (VK_ICD_FILENAMES=.../lvp_icd.x86_64.json). Pipeline, draw and
+  descriptor benchmarks use the shaders of the example (./shader.vert.spv and ./shader.frag.spv) and are skipped
+  without them. Swapchain recreation needs a window and only runs with --window.
+ */
+
+#include "purrr/purrr.hpp"
+#include "purrr/programBuilder.hpp"
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using bench::now;
+
+static const purrr::ContextInfo sContextInfo = [] {
+  purrr::ContextInfo info{ purrr::Version(1, 1, 0), purrr::VERSION, "purrr" };
+  info.appName  = "purrr_bench";
+  info.headless = true;
+  return info;
+}();
+
+static bench::Results sResults{};
+
+static void benchContextStartup() {
+  constexpr size_t ITERATIONS = 5;
+
+  double              total = 0.0, best = 1e9;
+  purrr::StartupStats phases{};
+  for (size_t i = 0; i < ITERATIONS; ++i) {
+    double          start   = now();
+    purrr::Context *context = purrr::Context::create(purrr::Api::Vulkan, sContextInfo);
+    double          time    = now() - start;
+
+    purrr::StartupStats stats = context->getStartupStats();
+    phases.instance          += stats.instance;
+    phases.deviceSelection   += stats.deviceSelection;
+    phases.device            += stats.device;
+    phases.resources         += stats.resources;
+    delete context;
+
+    total += time;
+    best   = std::min(best, time);
+  }
+
+  sResults.add(
+      "contextStartup",
+      { { "iterations", ITERATIONS },
+        { "mean", total / ITERATIONS },
+        { "min", best },
+        { "instance", phases.instance / ITERATIONS },
+        { "deviceSelection", phases.deviceSelection / ITERATIONS },
+        { "device", phases.device / ITERATIONS },
+        { "resources", phases.resources / ITERATIONS } });
+}
+
+static void benchBufferUpload(purrr::Context *context) {
+  for (size_t size : { 4ull << 10, 64ull << 10, 1ull << 20, 16ull << 20, 64ull << 20 }) {
+    // Roughly 256 MiB per size, but enough copies to average out small ones
+    size_t iterations = std::max<size_t>(8, std::min<size_t>(1000, (256ull << 20) / size));
+
+    std::vector<uint8_t> data(size, 0xAB);
+    purrr::Buffer       *buffer = context->createBuffer({ purrr::BufferType::Vertex, size, "bench buffer" });
+
+    buffer->copy(data.data(), 0, size); // Warm up
+    double start = now();
+    for (size_t i = 0; i < iterations; ++i) buffer->copy(data.data(), 0, size);
+    double time = now() - start;
+
+    delete buffer;
+
+    sResults.add(
+        "bufferUpload",
+        { { "size", size },
+          { "iterations", iterations },
+          { "mean", time / iterations },
+          { "bytesPerSecond", size * iterations / time } });
+  }
+}
+
+static void benchImageUpload(purrr::Context *context, purrr::Sampler *sampler) {
+  for (size_t extent : { 256, 1024, 4096 }) {
+    size_t size       = extent * extent * 4;
+    size_t iterations = std::max<size_t>(4, std::min<size_t>(200, (256ull << 20) / size));
+
+    std::vector<uint8_t> data(size, 0x7F);
+    purrr::ImageInfo     info{
+      extent, extent, purrr::Format::RGBA8Unorm, purrr::ImageTiling::Optimal, { true, false, false, false }, sampler
+    };
+    info.name           = "bench image";
+    purrr::Image *image = context->createImage(info);
+
+    image->copyData(extent, extent, size, data.data()); // Warm up
+    double start = now();
+    for (size_t i = 0; i < iterations; ++i) image->copyData(extent, extent, size, data.data());
+    double time = now() - start;
+
+    delete image;
+
+    sResults.add(
+        "imageUpload",
+        { { "width", extent },
+          { "height", extent },
+          { "iterations", iterations },
+          { "mean", time / iterations },
+          { "bytesPerSecond", size * iterations / time } });
+  }
+}
+
+static purrr::Program *buildProgram(purrr::RenderTarget *target, purrr::Shader *vertex, purrr::Shader *fragment) {
+  return purrr::ProgramBuilder()
+      .addShader(vertex)
+      .addShader(fragment)
+      .setCullMode(purrr::CullMode::Back)
+      .setFrontFace(purrr::FrontFace::CounterClockwise)
+      .setTopology(purrr::Topology::TriangleStrip)
+      .addSlot(purrr::ProgramSlot::Texture)
+      .build(target);
+}
+
+// The driver may keep its own cache on disk, set MESA_SHADER_CACHE_DISABLE=true for a truly cold first creation
+static void benchPipelineCreation(purrr::RenderTarget *target, purrr::Shader *vertex, purrr::Shader *fragment) {
+  constexpr size_t ITERATIONS = 20;
+
+  double          start = now();
+  purrr::Program *first = buildProgram(target, vertex, fragment);
+  double          cold  = now() - start;
+  delete first;
+
+  start = now();
+  for (size_t i = 0; i < ITERATIONS; ++i) delete buildProgram(target, vertex, fragment);
+  double cached = (now() - start) / ITERATIONS;
+
+  sResults.add("pipelineCreation", { { "iterations", ITERATIONS }, { "cold", cold }, { "cached", cached } });
+}
+
+// CPU time from record() to submit(), the device only runs behind
+static void benchDrawSubmission(
+    purrr::Context *context, purrr::RenderTarget *target, purrr::Program *program, purrr::Image *texture) {
+  constexpr size_t FRAMES = 20, DRAWS = 10000;
+  const std::vector<purrr::ContextClearValue> clearValues = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+  double total = 0.0;
+  for (size_t frame = 0; frame < FRAMES; ++frame) {
+    context->begin();
+    double start = now();
+    context->record(target, { clearValues });
+    context->useProgram(program);
+    context->useTextureImage(texture, 0);
+    for (size_t i = 0; i < DRAWS; ++i) context->draw(4);
+    context->end();
+    context->submit();
+    total += now() - start;
+  }
+  context->waitIdle();
+
+  sResults.add(
+      "drawSubmission",
+      { { "frames", FRAMES },
+        { "drawsPerFrame", DRAWS },
+        { "meanFrame", total / FRAMES },
+        { "drawsPerSecond", FRAMES * DRAWS / total } });
+}
+
+static void benchDescriptorBind(
+    purrr::Context *context, purrr::RenderTarget *target, purrr::Program *program, purrr::Image *textures[2]) {
+  constexpr size_t FRAMES = 20, BINDS = 10000;
+  const std::vector<purrr::ContextClearValue> clearValues = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+  double total = 0.0;
+  for (size_t frame = 0; frame < FRAMES; ++frame) {
+    context->begin();
+    context->record(target, { clearValues });
+    context->useProgram(program);
+    double start = now();
+    for (size_t i = 0; i < BINDS; ++i) context->useTextureImage(textures[i % 2], 0);
+    total += now() - start;
+    context->draw(4);
+    context->end();
+    context->submit();
+  }
+  context->waitIdle();
+
+  sResults.add(
+      "descriptorBind",
+      { { "frames", FRAMES }, { "bindsPerFrame", BINDS }, { "meanBind", total / (FRAMES * BINDS) } });
+}
+
+// Recreation happens in the present() after a resize and shows up in the stats of the following frame
+static void benchSwapchainRecreation() {
+  constexpr size_t ITERATIONS = 10, MAX_FRAMES = 100;
+
+  purrr::ContextInfo info = sContextInfo;
+  info.headless           = false;
+  purrr::Context *context = purrr::Context::create(purrr::Api::Vulkan, info);
+  purrr::Window  *window  = context->createWindow({ 640, 480, "purrr bench" });
+  const std::vector<purrr::ContextClearValue> clearValues = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+  double total = 0.0, lastPresent = 0.0;
+  size_t recreations = 0;
+  for (size_t i = 0; i < ITERATIONS; ++i) {
+    window->setSize(i % 2 ? std::make_pair(640, 480) : std::make_pair(800, 600));
+
+    for (size_t frame = 0; frame < MAX_FRAMES; ++frame) {
+      context->pollWindowEvents();
+      context->begin();
+      if (context->record(window, { clearValues })) context->end();
+      context->submit();
+
+      if (frame > 0 && context->getFrameStats().swapchainRecreations > 0) {
+        total += lastPresent;
+        ++recreations;
+        break;
+      }
+
+      double start = now();
+      context->present();
+      lastPresent = now() - start;
+    }
+  }
+  context->waitIdle();
+
+  delete window;
+  delete context;
+
+  if (recreations > 0)
+    sResults.add("swapchainRecreation", { { "iterations", recreations }, { "mean", total / recreations } });
+  else
+    sResults.skip("swapchainRecreation", "resizing never recreated the swapchain");
+}
+
+int main(int argc, char **argv) {
+  const char *output = nullptr;
+  bool        window = false;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--window") == 0)
+      window = true;
+    else
+      output = argv[i];
+  }
+
+  benchContextStartup();
+
+  purrr::Context *context = purrr::Context::create(purrr::Api::Vulkan, sContextInfo);
+  purrr::Sampler *sampler = context->createSampler({ purrr::Filter::Nearest,
+                                                     purrr::Filter::Nearest,
+                                                     purrr::Filter::Nearest,
+                                                     purrr::SamplerAddressMode::Repeat,
+                                                     purrr::SamplerAddressMode::Repeat,
+                                                     purrr::SamplerAddressMode::Repeat });
+
+  benchBufferUpload(context);
+  benchImageUpload(context, sampler);
+
+  std::vector<char> vertexCode{}, fragmentCode{};
+  if (bench::readFile("./shader.vert.spv", vertexCode) && bench::readFile("./shader.frag.spv", fragmentCode)) {
+    purrr::Shader *vertex   = context->createShader(purrr::ShaderType::Vertex, vertexCode);
+    purrr::Shader *fragment = context->createShader(purrr::ShaderType::Fragment, fragmentCode);
+
+    purrr::ImageInfo colorInfo{
+      256, 256, purrr::Format::RGBA8Unorm, purrr::ImageTiling::Optimal, { false, true, false, false }
+    };
+    purrr::Image        *color  = context->createImage(colorInfo);
+    purrr::RenderTarget *target = context->createRenderTarget({ 256, 256, &color, 1 });
+
+    purrr::ImageInfo textureInfo{
+      16, 16, purrr::Format::RGBA8Unorm, purrr::ImageTiling::Optimal, { true, false, false, false }, sampler
+    };
+    purrr::Image *textures[2] = { context->createImage(textureInfo), context->createImage(textureInfo) };
+    std::vector<uint8_t> pixels(16 * 16 * 4, 0xFF);
+    for (purrr::Image *texture : textures) texture->copyData(16, 16, pixels.size(), pixels.data());
+
+    benchPipelineCreation(target, vertex, fragment);
+
+    purrr::Program *program = buildProgram(target, vertex, fragment);
+    benchDrawSubmission(context, target, program, textures[0]);
+    benchDescriptorBind(context, target, program, textures);
+
+    delete program;
+    delete textures[0];
+    delete textures[1];
+    delete target;
+    delete color;
+    delete fragment;
+    delete vertex;
+  } else {
+    for (const char *name : { "pipelineCreation", "drawSubmission", "descriptorBind" })
+      sResults.skip(name, "shader.vert.spv and shader.frag.spv not found");
+  }
+
+  delete sampler;
+  delete context;
+
+  if (window)
+    benchSwapchainRecreation();
+  else
+    sResults.skip("swapchainRecreation", "needs --window");
+
+  return sResults.write(output) ? 0 : 1;
+}
\ No newline at end of file
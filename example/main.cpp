@@ -28,8 +28,12 @@ static purrr::Sampler *sSampler = nullptr;
 
 struct Canvas {
   Canvas(size_t width, size_t height)
-    : image(sContext->createImage(
-          { width, height, purrr::Format::RGBA8Srgb, purrr::ImageTiling::Optimal, { true, false }, sSampler })),
+    : image(sContext->createImage({ width,
+                                    height,
+                                    purrr::Format::RGBA8Srgb,
+                                    purrr::ImageTiling::Optimal,
+                                    { true, false, false, false },
+                                    sSampler })),
       pixels(new uint8_t[width * height * 4]),
       width(width),
       height(height) {
@@ -46,6 +50,8 @@ struct Canvas {
   }
 
   void draw(size_t x, size_t y) {
+    if (x < 1 || y < 1 || x + 1 >= width || y + 1 >= height) return;
+
     for (int oy = -1; oy <= 1; ++oy) {
       size_t index = (y + oy) * width + x - 1;
       for (int i = 0; i < 3; ++i) {
@@ -56,7 +62,9 @@ struct Canvas {
         ++index;
       }
     }
-    image->copyData(width, height, width * height * 4, pixels);
+
+    // Only the brush area changed, the rest of the canvas stays on the device
+    image->copyRegion(x - 1, y - 1, 3, 3, 0, 0, width * 4, pixels + ((y - 1) * width + x - 1) * 4);
   }
 
   purrr::Image *image;
@@ -91,6 +99,7 @@ int main(void) {
   Canvas canvas(window->getSize().first, window->getSize().second);
 
   while (!window->shouldClose()) { // Windows passed to `record` MUST NOT be destroyed before `present`
+    sContext->waitForNextFrame(); // Wait for the previous frame before sampling input
     sContext->pollWindowEvents();
 
     if (window->isMouseButtonDown(purrr::MouseButton::Left)) {
@@ -0,0 +1,48 @@
+#ifndef _PURRR_BATCH_RENDERER_HPP_
+#define _PURRR_BATCH_RENDERER_HPP_
+
+#include "purrr/object.hpp"
+#include "purrr/context.hpp"
+#include "purrr/format.hpp"
+#include "purrr/renderTarget.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace purrr {
+
+struct BatchJob {
+  size_t                                       width, height;
+  std::function<void(Context *)>               record = {}; // Called between record() and end() of the job's target
+  std::function<void(std::vector<uint8_t> &&)> done   = {}; // Receives the tightly packed pixels of the image
+};
+
+struct BatchRendererInfo {
+  Format                         format      = Format::RGBA8Unorm;
+  size_t                         targetCount = 4; // Render targets in flight, half of them are recorded per submission
+  std::vector<ContextClearValue> clearValues = { { { 0.0f, 0.0f, 0.0f, 0.0f } } };
+};
+
+class BatchRenderer : public Object {
+public:
+  BatchRenderer()          = default;
+  virtual ~BatchRenderer() = default;
+public:
+  BatchRenderer(const BatchRenderer &)            = delete;
+  BatchRenderer &operator=(const BatchRenderer &) = delete;
+public:
+  // Programs created for it can be used by every job
+  virtual RenderTarget *getRenderTarget() const      = 0;
+  virtual void          enqueue(const BatchJob &job) = 0;
+public:
+  // Submits the next batch and hands out the one whose render targets it reuses, returns false once every job was
+  // handed out. Batches are recorded into their own command buffers, call outside of record().
+  virtual bool step()   = 0;
+  virtual void finish() = 0;
+};
+
+} // namespace purrr
+
+#endif // _PURRR_BATCH_RENDERER_HPP_
\ No newline at end of file
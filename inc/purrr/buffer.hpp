@@ -2,6 +2,11 @@
 #define _PURRR_BUFFER_HPP_
 
 #include "purrr/object.hpp"
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
 namespace purrr {
 
 enum class BufferType {
@@ -12,8 +17,9 @@ enum class BufferType {
 };
 
 struct BufferInfo {
-  BufferType type;
-  size_t     size;
+  BufferType  type;
+  size_t      size;
+  const char *name = nullptr;
 };
 
 class Buffer : public purrr::Object {
@@ -25,6 +31,9 @@ public:
   Buffer &operator=(const Buffer &) = delete;
 public:
   virtual void copy(const void *data, size_t offset, size_t size) = 0;
+  // Copies the range to the host asynchronously, the future holds its bytes. Sees every submitted frame, so it
+  // cannot be called between begin() and submit().
+  virtual std::future<std::vector<uint8_t>> readback(size_t offset, size_t size) = 0;
 };
 
 } // namespace purrr
@@ -8,7 +8,12 @@
 #include "purrr/sampler.hpp"      // IWYU pragma: private
 #include "purrr/image.hpp"        // IWYU pragma: private
 #include "purrr/renderTarget.hpp" // IWYU pragma: private
+#include "purrr/query.hpp"        // IWYU pragma: private
+#include "purrr/device.hpp"       // IWYU pragma: private
 
+#include <functional>
+#include <ostream>
+#include <string>
 #include <vector>
 
 namespace purrr {
@@ -24,15 +29,72 @@ struct Version {
   uint32_t patch;
 };
 
+// Receives validation warnings and errors
+using DebugCallback = std::function<void(const char *message)>;
+
 struct ContextInfo {
-  Version     apiVersion    = {};
-  Version     engineVersion = {};
-  const char *engineName    = nullptr;
-  Version     appVersion    = {};
-  const char *appName       = nullptr;
-  bool        debug         = false;
+  Version         apiVersion       = {};
+  Version         engineVersion    = {};
+  const char     *engineName       = nullptr;
+  Version         appVersion       = {};
+  const char     *appName          = nullptr;
+  bool            debug            = false; // Validation, the names given to objects show up in messages and captures
+  bool            dynamicRendering = false; // Render without render pass objects where the device supports it
+  bool            headless         = false; // No windowing system, only render targets can be recorded
+  bool            presentWait      = false; // waitForNextFrame() waits for presentation where the device supports it
+  bool            gpuProfiling     = false; // Timestamps around every record() and scope, see getGpuTimings()
+  bool            memoryBudget     = false; // Driver budgets in getMemoryStats() where the device supports them
+  DeviceSelection device           = {};
+  DebugCallback   debugCallback    = {}; // Validation messages go to stderr without one
+};
+
+struct GpuTiming {
+  std::string name;
+  uint32_t    depth; // Number of enclosing scopes
+  double      milliseconds;
+};
+
+// Seconds spent in each phase of create()
+struct StartupStats {
+  double platform        = 0.0; // Windowing system connection
+  double instance        = 0.0;
+  double deviceSelection = 0.0;
+  double device          = 0.0; // Feature checks, device creation and function loading
+  double resources       = 0.0; // Queue, command buffer, fence and profiler
+  double total           = 0.0;
+  bool   cachedDevice    = false; // ContextInfo::device.uuid matched a suitable device
 };
 
+struct FrameStats {
+  uint64_t draws                = 0;
+  uint64_t pipelineBinds        = 0;
+  uint64_t descriptorBinds      = 0;
+  uint64_t vertexBufferBinds    = 0;
+  uint64_t indexBufferBinds     = 0;
+  uint64_t bytesUploaded        = 0;
+  uint64_t stagingAllocations   = 0;
+  uint64_t submits              = 0; // Including the ones of uploads and readbacks
+  uint64_t pipelineCompilations = 0;
+  uint64_t swapchainRecreations = 0;
+  double   fenceWaitTime        = 0.0; // Seconds blocked on the previous frame
+  double   acquireTime          = 0.0; // Seconds blocked acquiring window images
+};
+
+struct MemoryHeapStats {
+  uint64_t size        = 0;
+  uint64_t allocated   = 0; // By this context
+  uint64_t usage       = 0; // By the whole process with driver budgets, equal to allocated otherwise
+  uint64_t budget      = 0; // Equal to size without driver budgets
+  bool     deviceLocal = false;
+};
+
+struct MemoryStats {
+  std::vector<MemoryHeapStats> heaps = {};
+};
+
+// Receives the index of the heap that crossed the threshold
+using MemoryCallback = std::function<void(const MemoryStats &stats, uint32_t heap)>;
+
 struct ContextClearColor {
   float r, g, b, a;
 };
@@ -45,6 +107,10 @@ struct RecordClear {
   const std::vector<ContextClearValue> &clearValues;
 };
 
+class RenderGraph;
+class BatchRenderer;
+struct BatchRendererInfo;
+
 enum class IndexType {
   U16,
   U32
@@ -53,6 +119,8 @@ enum class IndexType {
 class Context : public Object {
 public:
   static Context *create(Api api, const ContextInfo &info = {});
+  // Devices the api can render with. Contexts share nothing, one per device spreads work over all of them.
+  static std::vector<DeviceDescription> enumerateDevices(Api api);
 public:
   Context()          = default;
   virtual ~Context() = default;
@@ -64,12 +132,15 @@ public:
   virtual void   waitForWindowEvents() const = 0;
   virtual double getTime() const             = 0;
 public:
-  virtual Window       *createWindow(const WindowInfo &info = {})        = 0;
-  virtual Buffer       *createBuffer(const BufferInfo &info = {})        = 0;
-  virtual Shader       *createShader(const ShaderInfo &info = {})        = 0;
-  virtual Sampler      *createSampler(const SamplerInfo &info)           = 0;
-  virtual Image        *createImage(const ImageInfo &info)               = 0;
-  virtual RenderTarget *createRenderTarget(const RenderTargetInfo &info) = 0;
+  virtual Window        *createWindow(const WindowInfo &info = {})          = 0;
+  virtual Buffer        *createBuffer(const BufferInfo &info = {})          = 0;
+  virtual Shader        *createShader(const ShaderInfo &info = {})          = 0;
+  virtual Sampler       *createSampler(const SamplerInfo &info)             = 0;
+  virtual Image         *createImage(const ImageInfo &info)                 = 0;
+  virtual RenderTarget  *createRenderTarget(const RenderTargetInfo &info)   = 0;
+  virtual RenderGraph   *createRenderGraph()                                = 0;
+  virtual BatchRenderer *createBatchRenderer(const BatchRendererInfo &info) = 0;
+  virtual Query         *createQuery(QueryType type)                        = 0;
 public:
   virtual Shader *createShader(ShaderType type, const std::vector<char> &code) = 0;
   virtual Shader *createShader(ShaderType type, const std::string_view &code)  = 0;
@@ -77,18 +148,61 @@ public:
   virtual void begin()                                                      = 0;
   virtual bool record(Window *window, const RecordClear &clear)             = 0;
   virtual bool record(RenderTarget *renderTarget, const RecordClear &clear) = 0;
+  virtual void nextSubpass()                                                = 0;
   virtual void useProgram(Program *program)                                 = 0;
   virtual void useVertexBuffer(Buffer *buffer, uint32_t index)              = 0;
   virtual void useIndexBuffer(Buffer *buffer, IndexType type)               = 0;
   virtual void useUniformBuffer(Buffer *buffer, uint32_t index)             = 0;
   virtual void useStorageBuffer(Buffer *buffer, uint32_t index)             = 0;
   virtual void useTextureImage(Image *image, uint32_t index)                = 0;
+  virtual void useInputAttachment(Image *image, uint32_t index)             = 0;
   virtual void draw(size_t vertexCount, size_t instanceCount = 1)           = 0;
   virtual void drawIndexed(size_t indexCount, size_t instanceCount = 1)     = 0;
   virtual void end()                                                        = 0;
   virtual void submit()                                                     = 0;
   virtual void present(bool preventSpinning = true)                         = 0;
   virtual void waitIdle()                                                   = 0;
+public:
+  // Seconds between two presents, 0 disables the limiter
+  virtual void setTargetFrameTime(double seconds) = 0;
+  // Waits for the previous frame and sleeps until the next one has to start, call right before pollWindowEvents() so
+  // input is sampled as late as possible
+  virtual void waitForNextFrame() = 0;
+  // Counters of the latest submitted frame, covering everything since the submit() before it
+  virtual FrameStats getFrameStats() const = 0;
+public:
+  virtual StartupStats getStartupStats() const = 0;
+  // Features of the description are the ones enabled on the device
+  virtual DeviceDescription getDeviceDescription() const = 0;
+  // Stays the same across runs, needs an apiVersion of at least 1.1 and is all zero otherwise
+  virtual DeviceUuid getDeviceUuid() const = 0;
+public:
+  virtual MemoryStats getMemoryStats() const = 0;
+  // Called once the usage of a heap rises above threshold times its budget, checked by allocations and begin(). A heap
+  // has to drop below the threshold again before it is reported another time.
+  virtual void setMemoryCallback(double threshold, MemoryCallback callback) = 0;
+public:
+  // GPU time between the two calls, scopes nest and may span record() calls but have to end before submit(). With
+  // debug they also label the commands in between.
+  virtual void beginScope(const char *name) = 0;
+  virtual void endScope()                   = 0;
+  // Timings of the latest frame whose results arrived, a few frames behind, in the order the scopes began
+  virtual std::vector<GpuTiming> getGpuTimings() const = 0;
+  // One line per scope, indented by depth
+  void dumpGpuTimings(std::ostream &stream) const;
+public:
+  // Records CPU spans of the frame functions, uploads and pipeline creation until stopTrace() writes them as Chrome
+  // trace JSON. Scopes show up on a GPU track while gpuProfiling is on.
+  virtual void startTrace()                    = 0;
+  virtual void stopTrace(std::ostream &stream) = 0;
+public:
+  // Every query is used at most once per frame and ends inside the record() it began in, or outside of any
+  virtual void beginQuery(Query *query) = 0;
+  virtual void endQuery(Query *query)   = 0;
+  // Skips draws until endConditional() while the latest result of the occlusion query recorded so far is zero, same
+  // nesting rules as queries. Draws are never skipped on devices without conditional rendering.
+  virtual void beginConditional(Query *query) = 0;
+  virtual void endConditional()               = 0;
 };
 
 } // namespace purrr
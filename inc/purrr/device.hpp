@@ -0,0 +1,57 @@
+#ifndef _PURRR_DEVICE_HPP_
+#define _PURRR_DEVICE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace purrr {
+
+// Identifies a device across processes, all zero when unknown
+using DeviceUuid = std::array<uint8_t, 16>;
+
+enum class DeviceType {
+  Other,
+  Integrated,
+  Discrete,
+  Virtual,
+  Cpu
+};
+
+// Optional capabilities, enabled whenever the chosen device supports them
+struct DeviceFeatures {
+  bool imageCubeArray         = false;
+  bool textureCompressionBC   = false;
+  bool textureCompressionETC2 = false;
+  bool textureCompressionASTC = false;
+  bool occlusionQueryPrecise  = false;
+  bool pipelineStatistics     = false;
+  bool timestamps             = false; // Needed by gpuProfiling
+};
+
+struct DeviceDescription {
+  std::string    name;
+  DeviceUuid     uuid;
+  DeviceType     type;
+  uint64_t       localMemory; // Bytes in device local heaps
+  DeviceFeatures features;
+};
+
+enum class DevicePreference {
+  Type,       // Discrete over integrated over CPU over virtual
+  MostMemory, // Largest device local heaps
+  First       // Enumeration order
+};
+
+// Devices failing a filter are never chosen, the preference picks among the rest
+struct DeviceSelection {
+  DeviceUuid       uuid       = {};      // Tried first, e.g. from getDeviceUuid() of an earlier run
+  bool             uuidOnly   = false;   // Fail instead of falling back to other devices when uuid does not match
+  const char      *name       = nullptr; // Only devices whose name contains it
+  DeviceFeatures   required   = {};      // Only devices supporting every feature set here
+  DevicePreference preference = DevicePreference::Type;
+};
+
+} // namespace purrr
+
+#endif // _PURRR_DEVICE_HPP_
\ No newline at end of file
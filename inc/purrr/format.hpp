@@ -1,6 +1,9 @@
 #ifndef _PURRR_FORMAT_HPP_
 #define _PURRR_FORMAT_HPP_
 
+#include <cstddef>
+#include <cstdint>
+
 namespace purrr {
 
 enum class Format {
@@ -134,9 +137,72 @@ enum class Format {
   S8Uint,
   D16UnormS8Uint,
   D24UnormS8Uint,
-  D32SfloatS8Uint
+  D32SfloatS8Uint,
+  BC1RGBUnormBlock,
+  BC1RGBSrgbBlock,
+  BC1RGBAUnormBlock,
+  BC1RGBASrgbBlock,
+  BC2UnormBlock,
+  BC2SrgbBlock,
+  BC3UnormBlock,
+  BC3SrgbBlock,
+  BC4UnormBlock,
+  BC4SnormBlock,
+  BC5UnormBlock,
+  BC5SnormBlock,
+  BC6HUfloatBlock,
+  BC6HSfloatBlock,
+  BC7UnormBlock,
+  BC7SrgbBlock,
+  ETC2RGB8UnormBlock,
+  ETC2RGB8SrgbBlock,
+  ETC2RGB8A1UnormBlock,
+  ETC2RGB8A1SrgbBlock,
+  ETC2RGBA8UnormBlock,
+  ETC2RGBA8SrgbBlock,
+  EACR11UnormBlock,
+  EACR11SnormBlock,
+  EACRG11UnormBlock,
+  EACRG11SnormBlock,
+  ASTC4x4UnormBlock,
+  ASTC4x4SrgbBlock,
+  ASTC5x4UnormBlock,
+  ASTC5x4SrgbBlock,
+  ASTC5x5UnormBlock,
+  ASTC5x5SrgbBlock,
+  ASTC6x5UnormBlock,
+  ASTC6x5SrgbBlock,
+  ASTC6x6UnormBlock,
+  ASTC6x6SrgbBlock,
+  ASTC8x5UnormBlock,
+  ASTC8x5SrgbBlock,
+  ASTC8x6UnormBlock,
+  ASTC8x6SrgbBlock,
+  ASTC8x8UnormBlock,
+  ASTC8x8SrgbBlock,
+  ASTC10x5UnormBlock,
+  ASTC10x5SrgbBlock,
+  ASTC10x6UnormBlock,
+  ASTC10x6SrgbBlock,
+  ASTC10x8UnormBlock,
+  ASTC10x8SrgbBlock,
+  ASTC10x10UnormBlock,
+  ASTC10x10SrgbBlock,
+  ASTC12x10UnormBlock,
+  ASTC12x10SrgbBlock,
+  ASTC12x12UnormBlock,
+  ASTC12x12SrgbBlock
+};
+
+struct FormatBlock {
+  uint32_t width, height; // Texels covered by one block, 1x1 for uncompressed formats
+  size_t   size;          // Bytes per block
 };
 
+FormatBlock formatBlock(Format format);
+// Bytes taken by a tightly packed width x height region, partial blocks at the edges count as whole
+size_t formatRegionSize(Format format, size_t width, size_t height);
+
 } // namespace purrr
 
 #endif // _PURRR_FORMAT_HPP_
\ No newline at end of file
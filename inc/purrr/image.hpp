@@ -6,14 +6,27 @@
 #include "purrr/sampler.hpp"
 
 #include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
 
 namespace purrr {
 
+static constexpr uint32_t FULL_MIP_CHAIN = 0; // Mip levels down to 1x1
+
 enum class ImageTiling {
   Linear,
   Optimal
 };
 
+enum class ImageType {
+  Image2D,
+  Image2DArray,
+  ImageCube,      // Six layers, +X -X +Y -Y +Z -Z
+  ImageCubeArray, // Six layers per cube
+  Image3D
+};
+
 struct ImageInfo {
   size_t      width, height;
   Format      format;
@@ -21,8 +34,23 @@ struct ImageInfo {
   struct Usage {
     uint8_t texture : 1;
     uint8_t renderTarget : 1;
+    uint8_t transient : 1; // Render target contents never leave the render pass, backed by lazily allocated memory
+    uint8_t inputAttachment : 1;
   } usage;
-  Sampler *sampler = nullptr;
+  Sampler    *sampler   = nullptr;
+  uint32_t    mipLevels = 1;
+  ImageType   type      = ImageType::Image2D;
+  size_t      depth     = 1; // Only used by 3D images
+  uint32_t    layers    = 1; // Array elements, cubes for cube arrays
+  const char *name      = nullptr;
+};
+
+struct ImageRegion {
+  size_t      x, y, width, height;
+  uint32_t    layer    = 0; // Depth slice for 3D images
+  uint32_t    mipLevel = 0;
+  size_t      rowPitch = 0; // Bytes between the starts of two rows (of blocks) in data, 0 when tightly packed
+  const void *data     = nullptr;
 };
 
 class Image : public Object {
@@ -33,7 +61,35 @@ public:
   Image(const Image &)            = delete;
   Image &operator=(const Image &) = delete;
 public:
-  virtual void copyData(size_t width, size_t height, size_t size, const void *data) = 0;
+  // Layers of cubes are indexed as cube * 6 + face, layers of 3D images are depth slices
+  virtual void copyData(
+      size_t      width,
+      size_t      height,
+      size_t      size,
+      const void *data,
+      uint32_t    mipLevel = 0,
+      uint32_t    layer    = 0) = 0;
+  // Uploads every region with a single copy
+  virtual void copyRegions(const ImageRegion *regions, size_t regionCount) = 0;
+
+  void copyRegion(
+      size_t      x,
+      size_t      y,
+      size_t      width,
+      size_t      height,
+      uint32_t    layer,
+      uint32_t    mipLevel,
+      size_t      rowPitch,
+      const void *data) {
+    ImageRegion region = { x, y, width, height, layer, mipLevel, rowPitch, data };
+    copyRegions(&region, 1);
+  }
+  // Copies the area to the host asynchronously, the future holds its rows (of blocks) tightly packed. Sees every
+  // submitted frame, so it cannot be called between begin() and submit().
+  virtual std::future<std::vector<uint8_t>> readback(
+      size_t x, size_t y, size_t width, size_t height, uint32_t layer = 0, uint32_t mipLevel = 0) = 0;
+  // Fills every level past the first by downsampling the previous one
+  virtual void generateMipmaps() = 0;
 };
 
 } // namespace purrr
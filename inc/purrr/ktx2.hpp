@@ -0,0 +1,18 @@
+#ifndef _PURRR_KTX2_HPP_
+#define _PURRR_KTX2_HPP_
+
+#include "purrr/context.hpp"
+#include "purrr/image.hpp"
+#include "purrr/sampler.hpp"
+
+#include <cstddef>
+
+namespace purrr {
+
+// Creates a texture from a KTX2 container in memory and uploads every level it stores, files without levels get
+// theirs generated. Supercompressed containers are not supported.
+Image *loadKtx2(Context *context, const void *data, size_t size, Sampler *sampler);
+
+} // namespace purrr
+
+#endif // _PURRR_KTX2_HPP_
\ No newline at end of file
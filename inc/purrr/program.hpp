@@ -69,7 +69,8 @@ enum class FrontFace {
 enum class ProgramSlot {
   Texture,
   UniformBuffer,
-  StorageBuffer
+  StorageBuffer,
+  InputAttachment
 };
 
 struct ProgramInfo {
@@ -82,6 +83,8 @@ struct ProgramInfo {
   FrontFace         frontFace;
   ProgramSlot      *slots;
   size_t            slotCount;
+  uint32_t          subpass = 0;
+  const char       *name    = nullptr;
 };
 
 class Program : public Object {
@@ -76,6 +76,11 @@ public:
     mFrontFace = frontFace;
     return *this;
   }
+
+  ProgramBuilder &setSubpass(uint32_t subpass) {
+    mSubpass = subpass;
+    return *this;
+  }
 public:
   template <
       typename T,
@@ -97,7 +102,8 @@ public:
                                                  mCullMode,
                                                  mFrontFace,
                                                  mSlots.data(),
-                                                 mSlots.size() });
+                                                 mSlots.size(),
+                                                 mSubpass });
   }
 private:
   std::vector<Shader *>        mMyShaders           = {};
@@ -109,6 +115,7 @@ private:
   Topology                     mTopology            = Topology::PointList;
   CullMode                     mCullMode            = CullMode::Both;
   FrontFace                    mFrontFace           = FrontFace::Clockwise;
+  uint32_t                     mSubpass             = 0;
 };
 
 } // namespace purrr
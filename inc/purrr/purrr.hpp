@@ -1,13 +1,18 @@
 #ifndef _PURRR_HPP_
 #define _PURRR_HPP_
 
-#include "purrr/context.hpp"      // IWYU pragma: export
-#include "purrr/window.hpp"       // IWYU pragma: export
-#include "purrr/buffer.hpp"       // IWYU pragma: export
-#include "purrr/program.hpp"      // IWYU pragma: export
-#include "purrr/sampler.hpp"      // IWYU pragma: export
-#include "purrr/image.hpp"        // IWYU pragma: export
-#include "purrr/renderTarget.hpp" // IWYU pragma: export
+#include "purrr/context.hpp"       // IWYU pragma: export
+#include "purrr/window.hpp"        // IWYU pragma: export
+#include "purrr/buffer.hpp"        // IWYU pragma: export
+#include "purrr/program.hpp"       // IWYU pragma: export
+#include "purrr/sampler.hpp"       // IWYU pragma: export
+#include "purrr/image.hpp"         // IWYU pragma: export
+#include "purrr/renderTarget.hpp"  // IWYU pragma: export
+#include "purrr/renderGraph.hpp"   // IWYU pragma: export
+#include "purrr/batchRenderer.hpp" // IWYU pragma: export
+#include "purrr/query.hpp"         // IWYU pragma: export
+#include "purrr/device.hpp"        // IWYU pragma: export
+#include "purrr/ktx2.hpp"          // IWYU pragma: export
 
 #include "purrr/config.hpp" // IWYU pragma: export
 
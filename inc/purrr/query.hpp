@@ -0,0 +1,39 @@
+#ifndef _PURRR_QUERY_HPP_
+#define _PURRR_QUERY_HPP_
+
+#include "purrr/object.hpp"
+
+#include <cstdint>
+
+namespace purrr {
+
+enum class QueryType {
+  Occlusion,
+  PipelineStatistics
+};
+
+struct PipelineStatistics {
+  uint64_t vertexShaderInvocations   = 0;
+  uint64_t clippingInvocations       = 0;
+  uint64_t clippingPrimitives        = 0; // Primitives left after clipping
+  uint64_t fragmentShaderInvocations = 0;
+  uint64_t computeShaderInvocations  = 0;
+};
+
+class Query : public Object {
+public:
+  Query()          = default;
+  virtual ~Query() = default;
+public:
+  Query(const Query &)            = delete;
+  Query &operator=(const Query &) = delete;
+public:
+  virtual QueryType getType() const = 0;
+  // Results of the latest frame that used the query and finished, false while there is none. Never waits.
+  virtual bool getSamples(uint64_t &samples) const                 = 0; // Occlusion queries only
+  virtual bool getStatistics(PipelineStatistics &statistics) const = 0; // Pipeline statistics queries only
+};
+
+} // namespace purrr
+
+#endif // _PURRR_QUERY_HPP_
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef _PURRR_RENDER_GRAPH_HPP_
+#define _PURRR_RENDER_GRAPH_HPP_
+
+#include "purrr/object.hpp"
+#include "purrr/context.hpp"
+#include "purrr/buffer.hpp"
+#include "purrr/image.hpp"
+#include "purrr/renderTarget.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace purrr {
+
+struct RenderGraphPassInfo {
+  const char                    *name          = nullptr;
+  RenderTarget                  *renderTarget  = nullptr; // Every image of the render target is written by the pass
+  std::vector<ContextClearValue> clearValues   = {};
+  std::vector<Image *>           sampledImages = {};
+  std::vector<Buffer *>          readBuffers   = {};
+  std::vector<Buffer *>          writeBuffers  = {}; // Storage buffers written from shaders
+  std::function<void(Context *)> record        = {}; // Called between record() and end()
+};
+
+class RenderGraph : public Object {
+public:
+  RenderGraph()          = default;
+  virtual ~RenderGraph() = default;
+public:
+  RenderGraph(const RenderGraph &)            = delete;
+  RenderGraph &operator=(const RenderGraph &) = delete;
+public:
+  // Owned by the graph, contents only live for a frame and memory is shared with images of other passes
+  virtual Image *createImage(const ImageInfo &info)       = 0;
+  virtual void   addPass(const RenderGraphPassInfo &info) = 0;
+  // Keeps the writing passes alive and leaves the image ready to be sampled after execute()
+  virtual void addOutput(Image *image) = 0;
+public:
+  virtual void compile() = 0;
+  virtual void execute() = 0; // Records every pass, call between begin() and submit()
+};
+
+} // namespace purrr
+
+#endif // _PURRR_RENDER_GRAPH_HPP_
\ No newline at end of file
@@ -9,11 +9,35 @@
 
 namespace purrr {
 
+enum class LoadOp {
+  Load,
+  Clear,
+  DontCare
+};
+
+enum class StoreOp {
+  Store,
+  DontCare
+};
+
+// Attachments are indices into RenderTargetInfo::images
+struct SubpassInfo {
+  const uint32_t *colorAttachments;
+  size_t          colorAttachmentCount;
+  const uint32_t *inputAttachments     = nullptr;
+  size_t          inputAttachmentCount = 0;
+};
+
 struct RenderTargetInfo {
-  int     width;
-  int     height;
-  Image **images;
-  size_t  imageCount;
+  int                width;
+  int                height;
+  Image            **images;
+  size_t             imageCount;
+  const LoadOp      *loadOps      = nullptr; // One per image, nullptr means LoadOp::Clear
+  const StoreOp     *storeOps     = nullptr; // One per image, nullptr means StoreOp::Store
+  const SubpassInfo *subpasses    = nullptr; // nullptr means a single subpass writing every image
+  size_t             subpassCount = 0;
+  const char        *name         = nullptr; // Also labels the commands recorded into the target
 };
 
 class RenderTarget : public Object {
@@ -0,0 +1,76 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#ifndef _PURRR_VULKAN_BATCH_RENDERER_HPP_
+#define _PURRR_VULKAN_BATCH_RENDERER_HPP_
+
+#include "purrr/batchRenderer.hpp"
+#include "purrr/vulkan/context.hpp"
+#include "purrr/vulkan/image.hpp"
+#include "purrr/vulkan/renderTarget.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace purrr {
+namespace vulkan {
+
+  class BatchRenderer : public purrr::BatchRenderer {
+  public:
+    BatchRenderer(Context *context, const BatchRendererInfo &info);
+    ~BatchRenderer();
+  public:
+    virtual Api api() const override { return Api::Vulkan; }
+  public:
+    virtual purrr::RenderTarget *getRenderTarget() const override { return mTemplate.renderTarget; }
+    virtual void                 enqueue(const BatchJob &job) override;
+  public:
+    virtual bool step() override;
+    virtual void finish() override;
+  private:
+    struct Target {
+      Image         *image          = nullptr;
+      RenderTarget  *renderTarget   = nullptr;
+      VkBuffer       readbackBuffer = VK_NULL_HANDLE; // Written by the batch that rendered the target
+      VkDeviceMemory readbackMemory = VK_NULL_HANDLE;
+      const uint8_t *pixels         = nullptr; // Mapped readback memory
+      size_t         pixelsSize     = 0;
+      size_t         width = 0, height = 0;
+      bool           busy  = false;
+    };
+
+    struct Pending {
+      Target                                      *target = nullptr;
+      std::function<void(std::vector<uint8_t> &&)> done   = {};
+    };
+
+    struct Batch {
+      VkCommandBuffer      commandBuffer = VK_NULL_HANDLE;
+      VkFence              fence         = VK_NULL_HANDLE;
+      bool                 inFlight      = false;
+      std::vector<Pending> jobs          = {};
+    };
+  private:
+    Context             *mContext   = nullptr;
+    BatchRendererInfo    mInfo      = {};
+    Target               mTemplate  = {}; // Never used for jobs, keeps programs built for it valid
+    std::vector<Target>  mTargets   = {};
+    std::deque<BatchJob> mJobs      = {};
+    size_t               mBatchSize = 0;
+    std::vector<Batch>   mBatches   = {}; // Submitted in order, each one only waited on before it is reused
+    size_t               mNextBatch = 0;  // Also the oldest batch in flight
+  private:
+    void    createTarget(Target *target, size_t width, size_t height);
+    void    destroyTarget(Target *target);
+    Target *acquireTarget(size_t width, size_t height);
+    void    submit(Batch *batch);
+    void    deliver(Batch *batch);
+  };
+
+} // namespace vulkan
+} // namespace purrr
+
+#endif // _PURRR_VULKAN_BATCH_RENDERER_HPP_
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
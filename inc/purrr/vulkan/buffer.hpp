@@ -19,6 +19,7 @@ namespace vulkan {
     virtual Api api() const override { return Api::Vulkan; }
   public:
     virtual void copy(const void *data, size_t offset, size_t size) override;
+    virtual std::future<std::vector<uint8_t>> readback(size_t offset, size_t size) override;
   public:
     BufferType      getType() const { return mType; }
     VkBuffer        getBuffer() const { return mBuffer; }
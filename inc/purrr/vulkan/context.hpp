@@ -7,8 +7,15 @@
 #include "purrr/object.hpp"
 
 #include "purrr/vulkan/program.hpp"
+#include "purrr/vulkan/readback.hpp"
+#include "purrr/vulkan/profiler.hpp"
+#include "purrr/vulkan/tracer.hpp"
 
+#include <array>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include <vulkan/vulkan.h> // IWYU pragma: export
@@ -21,42 +28,33 @@ namespace vulkan {
   VkIndexType vkIndexType(IndexType type);
 
   class Window;
+  class IRenderTarget;
+  class Query;
   class Context : public purrr::platform::Context {
+  public:
+    // Per frame resources are rotated over this many slots
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
   public:
     Context(const ContextInfo &info);
     ~Context();
   public:
-    Context(Context &&other)
-      : purrr::platform::Context((purrr::platform::Context &&)other) {
-      *this = std::move(other);
-    }
-
-    Context &operator=(Context &&other) {
-      if (this == &other) return *this;
-
-      mInstance         = other.mInstance;
-      mPhysicalDevice   = other.mPhysicalDevice;
-      mQueueFamilyIndex = other.mQueueFamilyIndex;
-      mDevice           = other.mDevice;
-      mQueue            = other.mQueue;
-
-      other.mInstance         = VK_NULL_HANDLE;
-      other.mPhysicalDevice   = VK_NULL_HANDLE;
-      other.mQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-      other.mDevice           = VK_NULL_HANDLE;
-      other.mQueue            = VK_NULL_HANDLE;
-
-      return *this;
-    }
+    static std::vector<DeviceDescription> enumerateDevices();
+  public:
+    // Owned objects keep a pointer to the context, contexts are only handed out by purrr::Context::create()
+    Context(Context &&)            = delete;
+    Context &operator=(Context &&) = delete;
   public:
     virtual Api api() const override { return Api::Vulkan; }
   public:
-    virtual purrr::Window       *createWindow(const WindowInfo &info) override;
-    virtual purrr::Buffer       *createBuffer(const BufferInfo &info) override;
-    virtual purrr::Shader       *createShader(const ShaderInfo &info) override;
-    virtual purrr::Sampler      *createSampler(const SamplerInfo &info) override;
-    virtual purrr::Image        *createImage(const ImageInfo &info) override;
-    virtual purrr::RenderTarget *createRenderTarget(const RenderTargetInfo &info) override;
+    virtual purrr::Window        *createWindow(const WindowInfo &info) override;
+    virtual purrr::Buffer        *createBuffer(const BufferInfo &info) override;
+    virtual purrr::Shader        *createShader(const ShaderInfo &info) override;
+    virtual purrr::Sampler       *createSampler(const SamplerInfo &info) override;
+    virtual purrr::Image         *createImage(const ImageInfo &info) override;
+    virtual purrr::RenderTarget  *createRenderTarget(const RenderTargetInfo &info) override;
+    virtual purrr::RenderGraph   *createRenderGraph() override;
+    virtual purrr::BatchRenderer *createBatchRenderer(const BatchRendererInfo &info) override;
+    virtual purrr::Query         *createQuery(QueryType type) override;
   public:
     virtual purrr::Shader *createShader(ShaderType type, const std::vector<char> &code) override;
     virtual purrr::Shader *createShader(ShaderType type, const std::string_view &code) override;
@@ -64,44 +62,137 @@ namespace vulkan {
     virtual void begin() override;
     virtual bool record(purrr::Window *window, const RecordClear &clear) override;
     virtual bool record(purrr::RenderTarget *renderTarget, const RecordClear &clear) override;
+    virtual void nextSubpass() override;
     virtual void useProgram(purrr::Program *program) override;
     virtual void useVertexBuffer(purrr::Buffer *buffer, uint32_t index) override;
     virtual void useIndexBuffer(purrr::Buffer *buffer, IndexType type) override;
     virtual void useUniformBuffer(purrr::Buffer *buffer, uint32_t index) override;
     virtual void useStorageBuffer(purrr::Buffer *buffer, uint32_t index) override;
     virtual void useTextureImage(purrr::Image *image, uint32_t index) override;
+    virtual void useInputAttachment(purrr::Image *image, uint32_t index) override;
     virtual void draw(size_t vertexCount, size_t instanceCount) override;
     virtual void drawIndexed(size_t indexCount, size_t instanceCount) override;
     virtual void end() override;
     virtual void submit() override;
     virtual void present(bool preventSpinning) override;
     virtual void waitIdle() override;
+  public:
+    virtual void setTargetFrameTime(double seconds) override;
+    virtual void waitForNextFrame() override;
+    // Called by windows destroying their swapchain
+    void forgetPresents(VkSwapchainKHR swapchain);
+  public:
+    virtual FrameStats getFrameStats() const override { return mFrameStats; }
+    // Counters of the frame being recorded, other objects add to them as well
+    FrameStats &getCurrentStats() { return mStats; }
+  public:
+    virtual StartupStats      getStartupStats() const override { return mStartupStats; }
+    virtual DeviceDescription getDeviceDescription() const override { return mDeviceDescription; }
+    virtual DeviceUuid        getDeviceUuid() const override { return mDeviceDescription.uuid; }
+  public:
+    virtual MemoryStats getMemoryStats() const override;
+    virtual void        setMemoryCallback(double threshold, MemoryCallback callback) override;
+  public:
+    virtual void                   beginScope(const char *name) override;
+    virtual void                   endScope() override;
+    virtual std::vector<GpuTiming> getGpuTimings() const override;
+  public:
+    virtual void startTrace() override;
+    virtual void stopTrace(std::ostream &stream) override;
+  public:
+    virtual void beginQuery(purrr::Query *query) override;
+    virtual void endQuery(purrr::Query *query) override;
+    virtual void beginConditional(purrr::Query *query) override;
+    virtual void endConditional() override;
   public:
     VkInstance       getInstance() const { return mInstance; }
     VkPhysicalDevice getPhysicalDevice() const { return mPhysicalDevice; }
+    // Optional features are enabled whenever the device supports them
+    const VkPhysicalDeviceFeatures &getEnabledFeatures() const { return mEnabledFeatures; }
     uint32_t         getQueueFamilyIndex() const { return mQueueFamilyIndex; }
     VkDevice         getDevice() const { return mDevice; }
     VkQueue          getQueue() const { return mQueue; }
     VkCommandPool    getCommandPool() const { return mCommandPool; }
     VkCommandBuffer  getCommandBuffer() const { return mCommandBuffer; }
-  public:
-    VkDescriptorSetLayout getTextureDescriptorSetLayout() const { return mTextureDescriptorSetLayout; }
-    VkDescriptorSetLayout getUniformDescriptorSetLayout() const { return mUniformDescriptorSetLayout; }
-    VkDescriptorSetLayout getStorageDescriptorSetLayout() const { return mStorageDescriptorSetLayout; }
-    VkDescriptorPool      getDescriptorPool() const { return mDescriptorPool; }
+    bool             usesDynamicRendering() const { return mDynamicRendering; }
+    bool             isHeadless() const { return mHeadless; }
+    bool             usesPresentWait() const { return mPresentWait; }
+    bool             usesConditionalRendering() const { return mConditionalRendering; }
+    bool             usesCalibratedTimestamps() const { return mCalibratedTimestamps; }
+    // Null while no trace is running
+    Tracer          *getTracer() const { return mTracer; }
+    // Every frame before the current one finished on the device
+    uint64_t         getFrameIndex() const { return mFrameIndex; }
+    uint32_t         getFrameSlot() const { return static_cast<uint32_t>(mFrameIndex % MAX_FRAMES_IN_FLIGHT); }
+    bool             isFrameOpen() const { return mFrameOpen; }
+    ReadbackRing    *getReadbackRing();
+  public: // Batch renderers record into their own command buffers, outside of begin() and submit()
+    void beginBatch(VkCommandBuffer commandBuffer);
+    void submitBatch(VkFence fence);
+    // Throws the batch away after a failure, leaving the context as it was before beginBatch()
+    void abortBatch();
+  public: // Debug utils, no-ops without debug, objects without a name are left unnamed
+    void setObjectName(VkObjectType type, uint64_t handle, const char *name);
+    void beginLabel(const char *name);
+    void endLabel();
+  public: // Created by the first object that needs them
+    VkDescriptorSetLayout getTextureDescriptorSetLayout();
+    VkDescriptorSetLayout getUniformDescriptorSetLayout();
+    VkDescriptorSetLayout getStorageDescriptorSetLayout();
+    VkDescriptorSetLayout getInputDescriptorSetLayout();
+    VkDescriptorPool      getDescriptorPool();
+  private:
+    VkInstance       mInstance             = VK_NULL_HANDLE;
+    VkPhysicalDevice mPhysicalDevice       = VK_NULL_HANDLE;
+    uint32_t         mQueueFamilyIndex     = VK_QUEUE_FAMILY_IGNORED;
+    VkDevice         mDevice               = VK_NULL_HANDLE;
+    VkQueue          mQueue                = VK_NULL_HANDLE;
+    VkCommandPool    mCommandPool          = VK_NULL_HANDLE;
+    VkCommandBuffer  mCommandBuffer        = VK_NULL_HANDLE;
+    VkFence          mFence                = VK_NULL_HANDLE;
+    uint64_t         mFrameIndex           = 0;     // Counted by begin()
+    bool             mFrameOpen            = false; // Between begin() and submit()
+    bool             mDebug                = false;
+    bool             mDynamicRendering     = false;
+    bool             mHeadless             = false;
+    bool             mPresentWait          = false;
+    bool             mConditionalRendering = false;
+    bool             mCalibratedTimestamps = false;
+    bool             mMemoryBudget         = false;
+    ReadbackRing    *mReadbackRing         = nullptr; // Created by the first readback
+    GpuProfiler     *mProfiler             = nullptr; // Only with gpuProfiling on queues writing timestamps
+    size_t           mRecordScope          = 0;       // Open scopes when record() began its own
+    Tracer          *mTracer               = nullptr; // Between startTrace() and stopTrace()
+    double           mRecordStart          = 0.0;     // Traced record() spans end in end()
+    FrameStats       mStats                = {};
+    FrameStats       mFrameStats           = {};      // Moved from mStats by submit()
+    StartupStats     mStartupStats         = {};
+    uint32_t         mApiVersion           = 0; // Of the instance
   private:
-    VkInstance       mInstance         = VK_NULL_HANDLE;
-    VkPhysicalDevice mPhysicalDevice   = VK_NULL_HANDLE;
-    uint32_t         mQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    VkDevice         mDevice           = VK_NULL_HANDLE;
-    VkQueue          mQueue            = VK_NULL_HANDLE;
-    VkCommandPool    mCommandPool      = VK_NULL_HANDLE;
-    VkCommandBuffer  mCommandBuffer    = VK_NULL_HANDLE;
-    VkFence          mFence            = VK_NULL_HANDLE;
+    VkPhysicalDeviceFeatures mEnabledFeatures   = {};
+    DeviceDescription        mDeviceDescription = {};
+  private: // Extensions of every device looked at, each device is enumerated once
+    std::unordered_map<VkPhysicalDevice, std::unordered_set<std::string>> mDeviceExtensions = {};
+  private: // Swapped out by beginBatch() until submitBatch(), GPU scopes are not timed inside batches
+    VkCommandBuffer mFrameCommandBuffer = VK_NULL_HANDLE;
+    GpuProfiler    *mFrameProfiler      = nullptr;
+  private: // Debug
+    VkDebugUtilsMessengerEXT mDebugMessenger = VK_NULL_HANDLE;
+    DebugCallback            mDebugCallback  = {}; // Messages go to stderr without one
+  private:
+    PFN_vkCmdBeginRenderingKHR            mCmdBeginRendering            = nullptr;
+    PFN_vkCmdEndRenderingKHR              mCmdEndRendering              = nullptr;
+    PFN_vkWaitForPresentKHR               mWaitForPresent               = nullptr;
+    PFN_vkCmdBeginConditionalRenderingEXT mCmdBeginConditionalRendering = nullptr;
+    PFN_vkCmdEndConditionalRenderingEXT   mCmdEndConditionalRendering   = nullptr;
+    PFN_vkSetDebugUtilsObjectNameEXT      mSetDebugUtilsObjectName      = nullptr;
+    PFN_vkCmdBeginDebugUtilsLabelEXT      mCmdBeginDebugUtilsLabel      = nullptr;
+    PFN_vkCmdEndDebugUtilsLabelEXT        mCmdEndDebugUtilsLabel        = nullptr;
   private:
     VkDescriptorSetLayout mTextureDescriptorSetLayout = VK_NULL_HANDLE;
     VkDescriptorSetLayout mUniformDescriptorSetLayout = VK_NULL_HANDLE;
     VkDescriptorSetLayout mStorageDescriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout mInputDescriptorSetLayout   = VK_NULL_HANDLE;
     VkDescriptorPool      mDescriptorPool             = VK_NULL_HANDLE;
   private: // Recorded windows
     std::vector<Window *>       mWindows          = {};
@@ -110,25 +201,69 @@ namespace vulkan {
     std::vector<VkSemaphore>    mImageSemaphores  = {};
     std::vector<VkSemaphore>    mSubmitSemaphores = {};
     bool                        mRecording        = false;
+    IRenderTarget              *mRenderTarget     = nullptr;
+    uint32_t                    mSubpass          = 0;
+    VkImage                     mPresentImage     = VK_NULL_HANDLE; // Transitioned for presentation by end()
     Program                    *mProgram          = nullptr;
     std::queue<Window *>        mRecreateQueue    = {};
+  private: // Queries
+    std::vector<Query *> mRecordQueries     = {}; // Begun inside the current record(), end() copies their results
+    size_t               mOpenQueries       = 0;
+    bool                 mConditional       = false;
+    bool                 mRecordConditional = false; // Conditional rendering began inside the current record()
+    bool                 mConditionalActive = false; // False while the query had no results to predicate on
+  private: // Memory
+    using Allocation = std::pair<uint32_t, VkDeviceSize>; // Heap and size
+
+    VkPhysicalDeviceMemoryProperties               mMemoryProperties   = {};
+    std::unordered_map<VkDeviceMemory, Allocation> mAllocations        = {};
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS>  mHeapAllocated      = {};
+    std::array<bool, VK_MAX_MEMORY_HEAPS>          mHeapsOverThreshold = {}; // Reported to the callback already
+    double                                         mMemoryThreshold    = 1.0;
+    MemoryCallback                                 mMemoryCallback     = {};
+  private: // Frame pacing
+    static constexpr uint64_t PRESENT_WAIT_TIMEOUT = 100'000'000; // Minimized windows may never present
+    static constexpr double   SLEEP_GRANULARITY    = 0.002;       // The last stretch before a wake up is spun
+
+    std::vector<std::pair<VkSwapchainKHR, uint64_t>> mLastPresents    = {};
+    double                                           mTargetFrameTime = 0.0;
+    double                                           mFrameDeadline   = 0.0;
+    double                                           mFrameStart      = 0.0;
+    double                                           mFrameWork       = 0.0; // Average waitForNextFrame() to present()
   private:
     void createInstance(const ContextInfo &info);
-    void chooseDevice(const std::vector<const char *> &extensions);
+    void createDebugMessenger();
+    void chooseDevice(const std::vector<const char *> &extensions, const DeviceSelection &selection);
     void createDevice(const std::vector<const char *> &extensions);
-    void getQueue();
+    void loadFunctions();
+    bool presentWaitSupported() const;
+    void retrieveQueue();
     void createCommandPool();
     void allocateCommandBuffer();
     void createFence();
+    void createDescriptors();
     void createDescriptorSetLayouts();
     void createDescriptorPool();
+  private:
+    void beginRendering(const VkRect2D &renderArea, const std::vector<VkRenderingAttachmentInfoKHR> &attachments);
+    void waitForFence();
+    void checkMemoryThreshold();
+    void transitionPresentImage();
   private:
     virtual uint32_t scorePhysicalDevice(VkPhysicalDevice device);
     bool             deviceExtensionsPresent(VkPhysicalDevice device, const std::vector<const char *> extensions);
+  private:
+    static DeviceUuid        queryDeviceUuid(VkPhysicalDevice device, uint32_t instanceVersion);
+    static DeviceDescription describeDevice(VkPhysicalDevice device, uint32_t instanceVersion);
   protected:
-    uint32_t findQueueFamily(VkPhysicalDevice device);
+    static uint32_t findQueueFamily(VkPhysicalDevice device);
   public:
     uint32_t        findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    uint32_t        findMemoryType(
+               uint32_t typeFilter, VkMemoryPropertyFlags preferred, VkMemoryPropertyFlags fallback);
+    // Every device memory goes through these so getMemoryStats() accounts for it
+    VkDeviceMemory  allocateMemory(const VkMemoryAllocateInfo &allocateInfo);
+    void            freeMemory(VkDeviceMemory memory);
     VkCommandBuffer beginSingleTimeCommands();
     void            submitSingleTimeCommands(VkCommandBuffer commandBuffer);
   };
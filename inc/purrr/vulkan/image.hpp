@@ -9,32 +9,59 @@
 namespace purrr {
 namespace vulkan {
 
-  VkImageTiling vkImageTiling(ImageTiling tiling);
+  VkImageTiling   vkImageTiling(ImageTiling tiling);
+  VkImageType     vkImageType(ImageType type);
+  VkImageViewType vkImageViewType(ImageType type);
 
   class Image : public purrr::Image {
   public:
-    Image(Context *context, const ImageInfo &info);
+    Image(Context *context, const ImageInfo &info, bool allocate = true);
     ~Image();
   public:
     virtual Api api() const override { return Api::Vulkan; }
   public:
-    virtual void copyData(size_t width, size_t height, size_t size, const void *data) override;
+    virtual void copyData(
+        size_t      width,
+        size_t      height,
+        size_t      size,
+        const void *data,
+        uint32_t    mipLevel = 0,
+        uint32_t    layer    = 0) override;
+    virtual void copyRegions(const ImageRegion *regions, size_t regionCount) override;
+    virtual std::future<std::vector<uint8_t>> readback(
+        size_t x, size_t y, size_t width, size_t height, uint32_t layer = 0, uint32_t mipLevel = 0) override;
+    virtual void generateMipmaps() override;
   public:
     Format          getFormat() const { return mFormat; }
     VkImage         getImage() const { return mImage; }
     VkImageView     getImageView() const { return mImageView; }
+    VkImageView     getAttachmentView() const { return mAttachmentView ? mAttachmentView : mImageView; }
+    uint32_t        getMipLevels() const { return mMipLevels; }
+    uint32_t        getArrayLayers() const { return mArrayLayers; }
     VkDescriptorSet getDescriptorSet() const { return mDescriptorSet; }
+    VkDescriptorSet getInputDescriptorSet() const { return mInputDescriptorSet; }
   public:
-    ImageInfo::Usage getUsage() const { return mUsage; }
+    ImageInfo::Usage     getUsage() const { return mUsage; }
+    VkImageLayout        getLayout() const { return mLayout; }
+    VkPipelineStageFlags getStage() const { return mStage; }
+    VkAccessFlags        getAccess() const { return mAccess; }
+    VkMemoryRequirements getMemoryRequirements() const;
   private:
-    Context        *mContext       = nullptr;
-    Format          mFormat        = Format::Undefined;
-    VkImage         mImage         = VK_NULL_HANDLE;
-    VkDeviceMemory  mMemory        = VK_NULL_HANDLE;
-    VkImageView     mImageView     = VK_NULL_HANDLE;
-    VkDescriptorSet mDescriptorSet = VK_NULL_HANDLE;
+    Context        *mContext            = nullptr;
+    Format          mFormat             = Format::Undefined;
+    VkImage         mImage              = VK_NULL_HANDLE;
+    VkDeviceMemory  mMemory             = VK_NULL_HANDLE;
+    VkImageView     mImageView          = VK_NULL_HANDLE;
+    VkImageView     mAttachmentView     = VK_NULL_HANDLE; // First level and layer, for layered or mipmapped targets
+    VkDescriptorSet mDescriptorSet      = VK_NULL_HANDLE;
+    purrr::Sampler *mSampler            = nullptr;
+    VkDescriptorSet mInputDescriptorSet = VK_NULL_HANDLE;
   private:
     ImageInfo::Usage mUsage;
+    ImageType        mType        = ImageType::Image2D;
+    VkExtent3D       mExtent      = {};
+    uint32_t         mMipLevels   = 1;
+    uint32_t         mArrayLayers = 1;
   private:
     VkImageLayout        mLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     VkPipelineStageFlags mStage  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
@@ -42,14 +69,29 @@ namespace vulkan {
   private:
     void createImage(const ImageInfo &info);
     void allocateMemory();
-    void createImageView(const ImageInfo &info);
+    void createViews();
+    void createImageView();
+    void createAttachmentView();
     void allocateDescriptorSet(purrr::Sampler *sampler);
+    void allocateInputDescriptorSet();
+  public:
+    // Images created without allocating are bound by their owner before use
+    void bindMemory(VkDeviceMemory memory, VkDeviceSize offset);
   public:
     void transitionImageLayout(
         VkImageLayout        dstLayout,
         VkPipelineStageFlags dstStage,
         VkAccessFlags        dstAccess,
         VkCommandBuffer      commandBuffer = VK_NULL_HANDLE);
+    bool prepareTransition(
+        VkImageLayout         dstLayout,
+        VkPipelineStageFlags  dstStage,
+        VkAccessFlags         dstAccess,
+        VkImageMemoryBarrier *barrier,
+        VkPipelineStageFlags *srcStage);
+    void assumeLayout(VkImageLayout layout, VkPipelineStageFlags stage, VkAccessFlags access);
+    // Records the copy, the image goes back to its layout afterwards
+    void copyToBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, const VkBufferImageCopy &copy);
   };
 
 } // namespace vulkan
@@ -0,0 +1,77 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#ifndef _PURRR_VULKAN_PROFILER_HPP_
+#define _PURRR_VULKAN_PROFILER_HPP_
+
+#include <vulkan/vulkan.h>
+
+#include "purrr/context.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace purrr {
+namespace vulkan {
+
+  class Context;
+  class GpuProfiler {
+  public:
+    static constexpr uint32_t FRAME_COUNT = 3;   // Frames are read back once every frame in flight finished
+    static constexpr uint32_t MAX_SCOPES  = 256; // Per frame, later scopes are not timed
+  public:
+    GpuProfiler(Context *context);
+    ~GpuProfiler();
+  public:
+    GpuProfiler(const GpuProfiler &)            = delete;
+    GpuProfiler &operator=(const GpuProfiler &) = delete;
+  public:
+    // Queue families without timestamp support report 0
+    static uint32_t timestampBits(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+  public:
+    // Collects the results of the frame that used the slot before and resets its queries, true when they arrived
+    bool beginFrame(VkCommandBuffer commandBuffer, uint64_t frameIndex);
+    void beginScope(VkCommandBuffer commandBuffer, const char *name);
+    void endScope(VkCommandBuffer commandBuffer);
+    // Scopes that were begun but not ended yet
+    size_t getOpenScopeCount() const { return mOpenScopes.size(); }
+    // Scopes of the latest frame whose results arrived
+    const std::vector<GpuTiming> &getTimings() const { return mTimings; }
+    // Begin and end ticks of every timed scope, masked to the valid bits
+    const std::vector<uint64_t> &getTimestamps() const { return mTimestamps; }
+    uint64_t                     getTimingsFrame() const { return mTimingsFrame; }
+    double                       getPeriod() const { return mPeriod; }
+    uint64_t                     getMask() const { return mMask; }
+  private:
+    struct Scope {
+      std::string name  = {};
+      uint32_t    depth = 0;
+    };
+
+    struct Frame {
+      std::vector<Scope> scopes  = {}; // Scope i writes queries 2i and 2i + 1 of the frame
+      uint64_t           index   = 0;
+      bool               pending = false;
+    };
+  private:
+    Context                       *mContext      = nullptr;
+    VkQueryPool                    mQueryPool    = VK_NULL_HANDLE;
+    double                         mPeriod       = 0.0; // Nanoseconds per tick
+    uint64_t                       mMask         = 0;   // Bits written by the queue
+    std::array<Frame, FRAME_COUNT> mFrames       = {};
+    uint32_t                       mSlot         = 0;
+    std::vector<size_t>            mOpenScopes   = {};
+    std::vector<GpuTiming>         mTimings      = {};
+    std::vector<uint64_t>          mTimestamps   = {};
+    uint64_t                       mTimingsFrame = 0;
+  private:
+    bool collect(uint32_t slot);
+  };
+
+} // namespace vulkan
+} // namespace purrr
+
+#endif // _PURRR_VULKAN_PROFILER_HPP_
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
@@ -7,6 +7,8 @@
 
 #include "purrr/program.hpp"
 
+#include <vector>
+
 namespace purrr {
 namespace vulkan {
 
@@ -40,15 +42,20 @@ namespace vulkan {
   public:
     virtual Api api() const override { return Api::Vulkan; }
   public:
-    bool sameRenderTarget(IRenderTarget *renderTarget) const { return mRenderTarget == renderTarget; }
+    // Pipelines built for dynamic rendering work with any target of the same formats
+    bool compatibleWith(IRenderTarget *renderTarget) const;
   public:
     VkPipelineLayout getLayout() const { return mLayout; }
     VkPipeline       getPipeline() const { return mPipeline; }
+    uint32_t         getSubpass() const { return mSubpass; }
   private:
     IRenderTarget   *mRenderTarget = nullptr;
     Context         *mContext      = nullptr;
+    uint32_t         mSubpass      = 0;
     VkPipelineLayout mLayout       = VK_NULL_HANDLE;
     VkPipeline       mPipeline     = VK_NULL_HANDLE;
+  private:
+    std::vector<VkFormat> mColorFormats = {}; // Empty when built against a render pass
   private:
     void createLayout(const ProgramInfo &info);
     void createPipeline(const ProgramInfo &info);
@@ -0,0 +1,60 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#ifndef _PURRR_VULKAN_QUERY_HPP_
+#define _PURRR_VULKAN_QUERY_HPP_
+
+#include "purrr/query.hpp"
+#include "purrr/vulkan/context.hpp"
+
+#include <array>
+
+namespace purrr {
+namespace vulkan {
+
+  class Query : public purrr::Query {
+  public:
+    // Uses rotate over this many queries and result slots, the host only reads slots of finished frames
+    static constexpr uint32_t SLOT_COUNT = 3;
+  public:
+    Query(Context *context, QueryType type);
+    ~Query();
+  public:
+    virtual Api api() const override { return Api::Vulkan; }
+  public:
+    virtual QueryType getType() const override { return mType; }
+    virtual bool      getSamples(uint64_t &samples) const override;
+    virtual bool      getStatistics(PipelineStatistics &statistics) const override;
+  public:
+    void begin(VkCommandBuffer commandBuffer, uint64_t frameIndex);
+    void end(VkCommandBuffer commandBuffer);
+    // Outside of render passes, writes the results to the host and the predicate for conditional rendering
+    void copyResults(VkCommandBuffer commandBuffer);
+    bool isActive() const { return mActive; }
+    // Predicate of the latest copied results, false while there are none
+    bool getPredicate(VkBuffer &buffer, VkDeviceSize &offset) const;
+  private:
+    Context                         *mContext    = nullptr;
+    QueryType                        mType       = QueryType::Occlusion;
+    uint32_t                         mValueCount = 1; // 64 bit results per slot
+    VkQueryPool                      mQueryPool  = VK_NULL_HANDLE;
+    VkBuffer                         mBuffer     = VK_NULL_HANDLE; // Results of every slot, then their predicates
+    VkDeviceMemory                   mMemory     = VK_NULL_HANDLE;
+    const uint8_t                   *mMapped     = nullptr;
+    std::array<uint64_t, SLOT_COUNT> mFrames     = {}; // Frame whose results a slot holds, 0 while it holds none
+    uint32_t                         mSlot       = 0;
+    uint64_t                         mUses       = 0;
+    uint64_t                         mLastFrame  = 0;
+    bool                             mActive     = false;
+  private:
+    void         createQueryPool();
+    void         createBuffer();
+    VkDeviceSize predicateOffset(uint32_t slot) const;
+    bool         read(uint64_t *values) const;
+  };
+
+} // namespace vulkan
+} // namespace purrr
+
+#endif // _PURRR_VULKAN_QUERY_HPP_
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#ifndef _PURRR_VULKAN_READBACK_HPP_
+#define _PURRR_VULKAN_READBACK_HPP_
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace purrr {
+namespace vulkan {
+
+  class Context;
+  class ReadbackRing {
+  public:
+    // Copies are recorded into the ring buffer at the given offset
+    using Record = std::function<void(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)>;
+  public:
+    ReadbackRing(Context *context, VkDeviceSize capacity);
+    ~ReadbackRing();
+  public:
+    ReadbackRing(const ReadbackRing &)            = delete;
+    ReadbackRing &operator=(const ReadbackRing &) = delete;
+  public:
+    // Submits the copy without waiting for it, the future only blocks if the copy is still running when read
+    std::future<std::vector<uint8_t>> read(VkDeviceSize size, VkDeviceSize alignment, const Record &record);
+    // Moves the results of finished copies out of the ring, called once per frame
+    void poll();
+  private:
+    struct Request {
+      VkDeviceSize         offset        = 0;
+      VkDeviceSize         size          = 0;
+      VkFence              fence         = VK_NULL_HANDLE;
+      VkCommandBuffer      commandBuffer = VK_NULL_HANDLE;
+      bool                 done          = false;
+      std::vector<uint8_t> data          = {};
+    };
+  private:
+    Context        *mContext  = nullptr;
+    VkDeviceSize    mCapacity = 0;
+    VkDeviceSize    mHead     = 0;
+    VkBuffer        mBuffer   = VK_NULL_HANDLE;
+    VkDeviceMemory  mMemory   = VK_NULL_HANDLE;
+    const uint8_t  *mMapped   = nullptr;
+    std::deque<std::shared_ptr<Request>> mRequests = {}; // In submission order
+  private:
+    void         createBuffer();
+    void         destroyBuffer();
+    VkDeviceSize allocate(VkDeviceSize size, VkDeviceSize alignment);
+    void         retire(Request &request);
+    void         complete(const std::shared_ptr<Request> &request);
+  };
+
+} // namespace vulkan
+} // namespace purrr
+
+#endif // _PURRR_VULKAN_READBACK_HPP_
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#ifndef _PURRR_VULKAN_RENDER_GRAPH_HPP_
+#define _PURRR_VULKAN_RENDER_GRAPH_HPP_
+
+#include "purrr/renderGraph.hpp"
+#include "purrr/vulkan/context.hpp"
+#include "purrr/vulkan/buffer.hpp"
+#include "purrr/vulkan/image.hpp"
+#include "purrr/vulkan/renderTarget.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace purrr {
+namespace vulkan {
+
+  class RenderGraph : public purrr::RenderGraph {
+  public:
+    RenderGraph(Context *context);
+    ~RenderGraph();
+  public:
+    virtual Api api() const override { return Api::Vulkan; }
+  public:
+    virtual purrr::Image *createImage(const ImageInfo &info) override;
+    virtual void          addPass(const RenderGraphPassInfo &info) override;
+    virtual void          addOutput(purrr::Image *image) override;
+  public:
+    virtual void compile() override;
+    virtual void execute() override;
+  private:
+    struct Pass {
+      RenderGraphPassInfo   info          = {};
+      RenderTarget         *renderTarget  = nullptr;
+      std::vector<Image *>  sampledImages = {};
+      std::vector<Buffer *> readBuffers   = {};
+      std::vector<Buffer *> writeBuffers  = {};
+      std::vector<Image *>  firstUses     = {}; // Graph images whose contents start with this pass
+      std::vector<size_t>   producers     = {}; // Passes whose results this pass consumes
+      std::vector<size_t>   successors    = {};
+    };
+
+    struct BufferState {
+      VkPipelineStageFlags stage;
+      VkAccessFlags        access;
+    };
+  private:
+    Context                             *mContext  = nullptr;
+    std::vector<Pass>                    mPasses   = {};
+    std::vector<Image *>                 mImages   = {};
+    std::vector<Image *>                 mOutputs  = {};
+    std::vector<size_t>                  mOrder    = {};
+    std::vector<VkDeviceMemory>          mMemories = {};
+    std::unordered_map<Image *, Image *> mPrevious = {}; // Image that used the same memory before
+    bool                                 mCompiled = false;
+  private:
+    bool ownsImage(const void *image) const;
+    void sortPasses();
+    void cullPasses();
+    void aliasImages();
+    void recordPass(const Pass &pass, std::unordered_map<Buffer *, BufferState> *buffers);
+  private:
+    static BufferState readState(BufferType type);
+  };
+
+} // namespace vulkan
+} // namespace purrr
+
+#endif // _PURRR_VULKAN_RENDER_GRAPH_HPP_
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
@@ -7,14 +7,24 @@
 #include "purrr/vulkan/context.hpp"
 #include "purrr/vulkan/image.hpp"
 
+#include <string>
 #include <vector>
 
 namespace purrr {
 namespace vulkan {
 
+  VkAttachmentLoadOp  vkLoadOp(LoadOp loadOp);
+  VkAttachmentStoreOp vkStoreOp(StoreOp storeOp);
+
   class IRenderTarget : public purrr::RenderTarget {
   public:
-    virtual VkRenderPass getRenderPass() const = 0;
+    virtual VkRenderPass getRenderPass() const                           = 0;
+    virtual uint32_t     getSubpassCount() const                         = 0;
+    virtual uint32_t     getColorAttachmentCount(uint32_t subpass) const = 0;
+    // Used instead of the render pass when it is null
+    virtual std::vector<VkFormat> getColorFormats() const = 0;
+    // Pipelines built for one of two compatible render passes can be used with the other
+    virtual bool renderPassCompatible(const IRenderTarget *other) const = 0;
   };
 
   class RenderTarget : public IRenderTarget {
@@ -31,17 +41,35 @@ namespace vulkan {
     bool sameContext(Context *context) const { return mContext == context; }
   public:
     virtual VkRenderPass getRenderPass() const override { return mRenderPass; }
+    virtual uint32_t     getSubpassCount() const override;
+    virtual uint32_t     getColorAttachmentCount(uint32_t subpass) const override;
     VkFramebuffer        getFramebuffer() const { return mFramebuffer; }
+    uint32_t             getClearValueCount() const { return mClearValueCount; }
+    const std::string   &getName() const { return mName; }
+    virtual std::vector<VkFormat> getColorFormats() const override;
+    virtual bool                  renderPassCompatible(const IRenderTarget *other) const override;
+  public:
+    const std::vector<Image *> &getImages() const { return mImages; }
+    const std::vector<LoadOp>  &getLoadOps() const { return mLoadOps; }
+    const std::vector<StoreOp> &getStoreOps() const { return mStoreOps; }
   private:
     uint32_t mWidth = 0, mHeight = 0;
+    uint32_t mClearValueCount = 0;
   private:
-    Context             *mContext     = nullptr;
-    VkRenderPass         mRenderPass  = VK_NULL_HANDLE;
-    VkFramebuffer        mFramebuffer = VK_NULL_HANDLE;
-    std::vector<Image *> mImages      = {};
+    Context              *mContext               = nullptr;
+    std::string           mName                  = {};
+    VkRenderPass          mRenderPass            = VK_NULL_HANDLE;
+    VkFramebuffer         mFramebuffer           = VK_NULL_HANDLE;
+    std::vector<Image *>  mImages                = {};
+    std::vector<LoadOp>   mLoadOps               = {};
+    std::vector<StoreOp>  mStoreOps              = {};
+    std::vector<uint32_t> mColorAttachmentCounts = {}; // One per subpass
   private:
     void createRenderPass(const RenderTargetInfo &info);
-    void createFramebuffer(const RenderTargetInfo &info);
+  public:
+    void createFramebuffer();
+    // Moves every attachment into the layout the render pass expects
+    void prepareAttachments(std::vector<VkImageMemoryBarrier> *barriers, VkPipelineStageFlags *srcStage);
   };
 
 } // namespace vulkan
@@ -0,0 +1,79 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#ifndef _PURRR_VULKAN_TRACER_HPP_
+#define _PURRR_VULKAN_TRACER_HPP_
+
+#include <vulkan/vulkan.h>
+
+#include "purrr/context.hpp"
+
+#include "purrr/vulkan/profiler.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace purrr {
+namespace vulkan {
+
+  class Context;
+  class Tracer {
+  public:
+    Tracer(Context *context);
+  public:
+    Tracer(const Tracer &)            = delete;
+    Tracer &operator=(const Tracer &) = delete;
+  public:
+    double now() const;
+    void   addCpuSpan(const char *name, double start, double end);
+    void   addSubmit(uint64_t frameIndex, double time);
+    // Scopes of the latest frame the profiler collected, frames submitted before the trace started are skipped
+    void addGpuFrame(const GpuProfiler &profiler);
+    // Chrome trace event JSON, timestamps are relative to the start of the trace
+    void write(std::ostream &stream) const;
+  private:
+    struct Event {
+      std::string name     = {};
+      uint32_t    track    = 0; // 0 for CPU spans, 1 for GPU spans
+      double      start    = 0.0;
+      double      duration = 0.0;
+    };
+
+    struct Submit {
+      uint64_t frame = 0;
+      double   time  = 0.0;
+    };
+  private:
+    Context                                     *mContext                 = nullptr;
+    double                                       mStart                   = 0.0; // Time of startTrace()
+    std::vector<Event>                           mEvents                  = {};
+    std::array<Submit, GpuProfiler::FRAME_COUNT> mSubmits                 = {};
+    PFN_vkGetCalibratedTimestampsEXT             mGetCalibratedTimestamps = nullptr;
+    bool                                         mHostClock               = false; // Host timestamps match getTime()
+  private:
+    void loadCalibration();
+    bool calibrate(uint64_t &ticks, double &time) const;
+  };
+
+  // Adds a CPU span from construction to destruction, does nothing without a tracer
+  class TraceSpan {
+  public:
+    TraceSpan(Tracer *tracer, const char *name);
+    ~TraceSpan();
+  public:
+    TraceSpan(const TraceSpan &)            = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+  private:
+    Tracer     *mTracer = nullptr;
+    const char *mName   = nullptr;
+    double      mStart  = 0.0;
+  };
+
+} // namespace vulkan
+} // namespace purrr
+
+#endif // _PURRR_VULKAN_TRACER_HPP_
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
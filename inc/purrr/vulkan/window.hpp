@@ -9,11 +9,14 @@
 
 #include "purrr/platform.hpp"
 
+#include <array>
 #include <utility>
 
 namespace purrr {
 namespace vulkan {
 
+  VkPresentModeKHR vkPresentMode(PresentMode mode);
+
   class Window : public purrr::platform::Window, public IRenderTarget {
   public:
     Window(Context *context, const WindowInfo &info);
@@ -35,6 +38,7 @@ namespace vulkan {
     virtual purrr::Program *createProgram(const ProgramInfo &info) override;
   public:
     virtual std::pair<int, int> getSize() const override { return purrr::platform::Window::getSize(); }
+    virtual PresentMode         getPresentMode() const override { return mPresentMode; }
   public:
     bool sameContext(Context *context) const { return context == mContext; }
   public:
@@ -42,15 +46,23 @@ namespace vulkan {
     VkFormat             getFormat() const { return mFormat; }
     VkColorSpaceKHR      getColorSpace() const { return mColorSpace; }
     virtual VkRenderPass getRenderPass() const override { return mRenderPass; }
+    virtual uint32_t     getSubpassCount() const override { return 1; }
+    virtual uint32_t     getColorAttachmentCount(uint32_t) const override { return 1; }
+    virtual std::vector<VkFormat> getColorFormats() const override { return { mFormat }; }
+    virtual bool                  renderPassCompatible(const IRenderTarget *other) const override {
+      return other == this;
+    }
     VkExtent2D           getSwapchainExtent() const { return mSwapchainExtent; }
     VkSwapchainKHR       getSwapchain() const { return mSwapchain; }
+    uint64_t             nextPresentId() { return ++mPresentId; }
   public:
     const std::vector<VkImage>       &getImages() const { return mImages; }
     const std::vector<VkImageView>   &getImageViews() const { return mImageViews; }
     const std::vector<VkFramebuffer> &getFramebuffers() const { return mFramebuffers; }
   public:
     const std::vector<VkSemaphore> &getSubmitSemaphores() const { return mSubmitSemaphores; }
-    const VkSemaphore              &getImageSemaphore() const { return mImageSemaphore; }
+    // Rotated with the frame slot, a semaphore is only reused once the frame waiting on it finished
+    VkSemaphore getImageSemaphore() const { return mImageSemaphores[mContext->getFrameSlot()]; }
   private:
     Context        *mContext         = nullptr;
     VkSurfaceKHR    mSurface         = VK_NULL_HANDLE;
@@ -60,23 +72,39 @@ namespace vulkan {
     VkExtent2D      mSwapchainExtent = {};
     VkSwapchainKHR  mSwapchain       = VK_NULL_HANDLE;
     uint32_t        mImageCount      = 0;
+    PresentMode     mPresentMode     = PresentMode::Fifo;
+    uint32_t        mMinImageCount   = 0; // Requested in the window info
+    uint64_t        mPresentId       = 0; // Last id handed to the presentation engine, counted per swapchain
   private:
     std::vector<VkImage>       mImages       = {};
     std::vector<VkImageView>   mImageViews   = {};
     std::vector<VkFramebuffer> mFramebuffers = {};
   private:
-    std::vector<VkSemaphore> mSubmitSemaphores = {};
-    VkSemaphore              mImageSemaphore   = VK_NULL_HANDLE;
+    std::vector<VkSemaphore>                               mSubmitSemaphores = {}; // One per swapchain image
+    std::array<VkSemaphore, Context::MAX_FRAMES_IN_FLIGHT> mImageSemaphores  = {}; // One per frame slot
+  private:
+    struct RetiredSwapchain {
+      uint64_t                   frame        = 0; // Destroyed once a later frame began
+      VkSwapchainKHR             swapchain    = VK_NULL_HANDLE;
+      std::vector<VkImageView>   imageViews   = {};
+      std::vector<VkFramebuffer> framebuffers = {};
+      std::vector<VkSemaphore>   semaphores   = {};
+    };
+
+    std::vector<RetiredSwapchain> mRetired = {};
   private:
     void chooseSurfaceFormat();
+    void choosePresentMode(PresentMode requested);
     void createRenderPass();
-    void createSwapchain();
+    void createSwapchain(VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
     void createImageViews();
     void createFramebuffers();
     void createSemaphores();
     void cleanupSwapchain();
+    void retireSwapchain();
   public:
     bool recreateSwapchain();
+    void destroyRetired(bool all = false);
   };
 
 } // namespace vulkan
@@ -46,12 +46,14 @@ inline namespace win32 {
     HINSTANCE mInstance       = nullptr;
     ATOM      mWindowClass    = INVALID_ATOM;
     uint64_t  mTimerFrequency = 0;
+    double    mStartupTime    = 0.0;
   private:
     KeyCode mKeyCodes[512];
   private:
     void registerClass();
     void fillKeyCodeTable();
   protected:
+    double getPlatformStartupTime() const { return mStartupTime; }
 #ifdef _PURRR_BACKEND_VULKAN
     void appendRequiredVulkanExtensions(std::vector<const char *> &extensions);
 #endif
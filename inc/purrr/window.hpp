@@ -12,6 +12,13 @@ namespace purrr {
 
 static constexpr int LENGTH_CSTR = -1;
 
+enum class PresentMode {
+  Fifo,        // Waits for the vertical blank, always available
+  FifoRelaxed, // Presents late images right away, may tear
+  Mailbox,     // Replaces the queued image instead of waiting, falls back to Immediate
+  Immediate    // Never waits and may tear, falls back to Mailbox
+};
+
 struct WindowInfo {
   int         width       = -1;
   int         height      = -1;
@@ -19,6 +26,8 @@ struct WindowInfo {
   int         titleLength = LENGTH_CSTR;
   int         xPos        = -1;
   int         yPos        = -1;
+  PresentMode presentMode = PresentMode::Fifo; // Falls back to Fifo when unavailable
+  uint32_t    imageCount  = 0;                 // Swapchain images, 0 means one more than the surface minimum
 };
 
 namespace vulkan {
@@ -39,6 +48,8 @@ public:
   void registerCallback(EventCallback callback) { mCallbacks.push_back(callback); }
 public:
   virtual std::pair<int, int> getPosition() const = 0;
+  // The mode in use after falling back
+  virtual PresentMode getPresentMode() const = 0;
 public:
   virtual int getTitle(char *title, int length) const = 0;
 public:
@@ -55,13 +55,17 @@ inline namespace x11 {
     XAtom     aDeleteWindow = 0;
     XAtom     aNetWmName    = 0;
     XAtom     aUtf8String   = 0;
+    double    mStartupTime  = 0.0;
+  private: // Filled by the first key event, most tools never see one
+    mutable KeyCode mKeyCodes[256]  = {};
+    mutable bool    mKeyCodesFilled = false;
   private:
-    KeyCode mKeyCodes[256];
-  private:
-    void fillKeyCodeTable();
+    void    fillKeyCodeTable() const;
+    KeyCode getKeyCode(uint32_t keycode) const;
   private:
     void handleEvent(::XEvent event) const;
   protected:
+    double getPlatformStartupTime() const { return mStartupTime; }
 #ifdef _PURRR_BACKEND_VULKAN
     void appendRequiredVulkanExtensions(std::vector<const char *> &extensions);
 #endif
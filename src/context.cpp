@@ -3,6 +3,8 @@
 // Backends
 #include "purrr/vulkan/context.hpp"
 
+#include <iomanip>
+
 namespace purrr {
 
 Context *Context::create(Api api, const ContextInfo &info) {
@@ -12,4 +14,25 @@ Context *Context::create(Api api, const ContextInfo &info) {
   }
 }
 
+std::vector<DeviceDescription> Context::enumerateDevices(Api api) {
+  switch (api) {
+  case Api::Vulkan: return vulkan::Context::enumerateDevices();
+  default: return {};
+  }
+}
+
+void Context::dumpGpuTimings(std::ostream &stream) const {
+  // The formatting is put back, the stream belongs to the caller
+  std::ios_base::fmtflags flags     = stream.flags();
+  std::streamsize         precision = stream.precision();
+
+  for (const GpuTiming &timing : getGpuTimings()) {
+    stream << std::string(timing.depth * 2, ' ') << timing.name << ": " << std::fixed << std::setprecision(3)
+           << timing.milliseconds << " ms\n";
+  }
+
+  stream.flags(flags);
+  stream.precision(precision);
+}
+
 } // namespace purrr
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "purrr/format.hpp"
+#include "purrr/exceptions.hpp"
+
+namespace purrr {
+
+FormatBlock formatBlock(Format format) {
+  switch (format) {
+  case Format::Undefined: throw InvalidUse("Undefined format has no block size");
+  case Format::RG4UnormPack8:
+  case Format::R8Unorm:
+  case Format::R8Snorm:
+  case Format::R8Uscaled:
+  case Format::R8Sscaled:
+  case Format::R8Uint:
+  case Format::R8Sint:
+  case Format::R8Srgb:
+  case Format::S8Uint: return { 1, 1, 1 };
+  case Format::RGBA4UnormPack16:
+  case Format::BGRA4UnormPack16:
+  case Format::R5G6B5UnormPack16:
+  case Format::B5G6R5UnormPack16:
+  case Format::RGB5A1UnormPack16:
+  case Format::BGR5A1UnormPack16:
+  case Format::A1RGB5UnormPack16:
+  case Format::RG8Unorm:
+  case Format::RG8Snorm:
+  case Format::RG8Uscaled:
+  case Format::RG8Sscaled:
+  case Format::RG8Uint:
+  case Format::RG8Sint:
+  case Format::RG8Srgb:
+  case Format::R16Unorm:
+  case Format::R16Snorm:
+  case Format::R16Uscaled:
+  case Format::R16Sscaled:
+  case Format::R16Uint:
+  case Format::R16Sint:
+  case Format::R16Sfloat:
+  case Format::D16Unorm: return { 1, 1, 2 };
+  case Format::RGB8Unorm:
+  case Format::RGB8Snorm:
+  case Format::RGB8Uscaled:
+  case Format::RGB8Sscaled:
+  case Format::RGB8Uint:
+  case Format::RGB8Sint:
+  case Format::RGB8Srgb:
+  case Format::BGR8Unorm:
+  case Format::BGR8Snorm:
+  case Format::BGR8Uscaled:
+  case Format::BGR8Sscaled:
+  case Format::BGR8Uint:
+  case Format::BGR8Sint:
+  case Format::BGR8Srgb:
+  case Format::D16UnormS8Uint: return { 1, 1, 3 };
+  case Format::RGBA8Unorm:
+  case Format::RGBA8Snorm:
+  case Format::RGBA8Uscaled:
+  case Format::RGBA8Sscaled:
+  case Format::RGBA8Uint:
+  case Format::RGBA8Sint:
+  case Format::RGBA8Srgb:
+  case Format::BGRA8Unorm:
+  case Format::BGRA8Snorm:
+  case Format::BGRA8Uscaled:
+  case Format::BGRA8Sscaled:
+  case Format::BGRA8Uint:
+  case Format::BGRA8Sint:
+  case Format::BGRA8Srgb:
+  case Format::ABGR8UnormPack32:
+  case Format::ABGR8SnormPack32:
+  case Format::ABGR8UscaledPack32:
+  case Format::ABGR8SscaledPack32:
+  case Format::ABGR8UintPack32:
+  case Format::ABGR8SintPack32:
+  case Format::ABGR8SrgbPack32:
+  case Format::A2RGB10UnormPack32:
+  case Format::A2RGB10SnormPack32:
+  case Format::A2RGB10UscaledPack32:
+  case Format::A2RGB10SscaledPack32:
+  case Format::A2RGB10UintPack32:
+  case Format::A2RGB10SintPack32:
+  case Format::A2BGR10UnormPack32:
+  case Format::A2BGR10SnormPack32:
+  case Format::A2BGR10UscaledPack32:
+  case Format::A2BGR10SscaledPack32:
+  case Format::A2BGR10UintPack32:
+  case Format::A2BGR10SintPack32:
+  case Format::RG16Unorm:
+  case Format::RG16Snorm:
+  case Format::RG16Uscaled:
+  case Format::RG16Sscaled:
+  case Format::RG16Uint:
+  case Format::RG16Sint:
+  case Format::RG16Sfloat:
+  case Format::R32Uint:
+  case Format::R32Sint:
+  case Format::R32Sfloat:
+  case Format::B10GR11UfloatPack32:
+  case Format::E5BGR9UfloatPack32:
+  case Format::X8D24UnormPack32:
+  case Format::D32Sfloat:
+  case Format::D24UnormS8Uint: return { 1, 1, 4 };
+  case Format::D32SfloatS8Uint: return { 1, 1, 5 };
+  case Format::RGB16Unorm:
+  case Format::RGB16Snorm:
+  case Format::RGB16Uscaled:
+  case Format::RGB16Sscaled:
+  case Format::RGB16Uint:
+  case Format::RGB16Sint:
+  case Format::RGB16Sfloat: return { 1, 1, 6 };
+  case Format::RGBA16Unorm:
+  case Format::RGBA16Snorm:
+  case Format::RGBA16Uscaled:
+  case Format::RGBA16Sscaled:
+  case Format::RGBA16Uint:
+  case Format::RGBA16Sint:
+  case Format::RGBA16Sfloat:
+  case Format::RG32Uint:
+  case Format::RG32Sint:
+  case Format::RG32Sfloat:
+  case Format::R64Uint:
+  case Format::R64Sint:
+  case Format::R64Sfloat: return { 1, 1, 8 };
+  case Format::RGB32Uint:
+  case Format::RGB32Sint:
+  case Format::RGB32Sfloat: return { 1, 1, 12 };
+  case Format::RGBA32Uint:
+  case Format::RGBA32Sint:
+  case Format::RGBA32Sfloat:
+  case Format::RG64Uint:
+  case Format::RG64Sint:
+  case Format::RG64Sfloat: return { 1, 1, 16 };
+  case Format::RGB64Uint:
+  case Format::RGB64Sint:
+  case Format::RGB64Sfloat: return { 1, 1, 24 };
+  case Format::RGBA64Uint:
+  case Format::RGBA64Sint:
+  case Format::RGBA64Sfloat: return { 1, 1, 32 };
+  case Format::BC1RGBUnormBlock:
+  case Format::BC1RGBSrgbBlock:
+  case Format::BC1RGBAUnormBlock:
+  case Format::BC1RGBASrgbBlock:
+  case Format::BC4UnormBlock:
+  case Format::BC4SnormBlock:
+  case Format::ETC2RGB8UnormBlock:
+  case Format::ETC2RGB8SrgbBlock:
+  case Format::ETC2RGB8A1UnormBlock:
+  case Format::ETC2RGB8A1SrgbBlock:
+  case Format::EACR11UnormBlock:
+  case Format::EACR11SnormBlock: return { 4, 4, 8 };
+  case Format::BC2UnormBlock:
+  case Format::BC2SrgbBlock:
+  case Format::BC3UnormBlock:
+  case Format::BC3SrgbBlock:
+  case Format::BC5UnormBlock:
+  case Format::BC5SnormBlock:
+  case Format::BC6HUfloatBlock:
+  case Format::BC6HSfloatBlock:
+  case Format::BC7UnormBlock:
+  case Format::BC7SrgbBlock:
+  case Format::ETC2RGBA8UnormBlock:
+  case Format::ETC2RGBA8SrgbBlock:
+  case Format::EACRG11UnormBlock:
+  case Format::EACRG11SnormBlock:
+  case Format::ASTC4x4UnormBlock:
+  case Format::ASTC4x4SrgbBlock: return { 4, 4, 16 };
+  case Format::ASTC5x4UnormBlock:
+  case Format::ASTC5x4SrgbBlock: return { 5, 4, 16 };
+  case Format::ASTC5x5UnormBlock:
+  case Format::ASTC5x5SrgbBlock: return { 5, 5, 16 };
+  case Format::ASTC6x5UnormBlock:
+  case Format::ASTC6x5SrgbBlock: return { 6, 5, 16 };
+  case Format::ASTC6x6UnormBlock:
+  case Format::ASTC6x6SrgbBlock: return { 6, 6, 16 };
+  case Format::ASTC8x5UnormBlock:
+  case Format::ASTC8x5SrgbBlock: return { 8, 5, 16 };
+  case Format::ASTC8x6UnormBlock:
+  case Format::ASTC8x6SrgbBlock: return { 8, 6, 16 };
+  case Format::ASTC8x8UnormBlock:
+  case Format::ASTC8x8SrgbBlock: return { 8, 8, 16 };
+  case Format::ASTC10x5UnormBlock:
+  case Format::ASTC10x5SrgbBlock: return { 10, 5, 16 };
+  case Format::ASTC10x6UnormBlock:
+  case Format::ASTC10x6SrgbBlock: return { 10, 6, 16 };
+  case Format::ASTC10x8UnormBlock:
+  case Format::ASTC10x8SrgbBlock: return { 10, 8, 16 };
+  case Format::ASTC10x10UnormBlock:
+  case Format::ASTC10x10SrgbBlock: return { 10, 10, 16 };
+  case Format::ASTC12x10UnormBlock:
+  case Format::ASTC12x10SrgbBlock: return { 12, 10, 16 };
+  case Format::ASTC12x12UnormBlock:
+  case Format::ASTC12x12SrgbBlock: return { 12, 12, 16 };
+  }
+
+  throw Unreachable();
+}
+
+size_t formatRegionSize(Format format, size_t width, size_t height) {
+  FormatBlock block = formatBlock(format);
+  return ((width + block.width - 1) / block.width) * ((height + block.height - 1) / block.height) * block.size;
+}
+
+} // namespace purrr
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "purrr/ktx2.hpp"
+#include "purrr/exceptions.hpp"
+
+// Backends
+#include "purrr/vulkan/format.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace purrr {
+
+static constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct Ktx2Header {
+  uint8_t  identifier[12];
+  uint32_t vkFormat;
+  uint32_t typeSize;
+  uint32_t pixelWidth;
+  uint32_t pixelHeight;
+  uint32_t pixelDepth;
+  uint32_t layerCount;
+  uint32_t faceCount;
+  uint32_t levelCount;
+  uint32_t supercompressionScheme;
+  uint32_t dfdByteOffset;
+  uint32_t dfdByteLength;
+  uint32_t kvdByteOffset;
+  uint32_t kvdByteLength;
+  uint64_t sgdByteOffset;
+  uint64_t sgdByteLength;
+};
+
+struct Ktx2Level {
+  uint64_t byteOffset;
+  uint64_t byteLength;
+  uint64_t uncompressedByteLength;
+};
+
+static Format ktx2Format(Context *context, uint32_t vkFormat) {
+  switch (context->api()) {
+  case Api::Vulkan: return vulkan::format(static_cast<VkFormat>(vkFormat));
+  default: throw InvalidUse("KTX2 formats are not supported by the backend");
+  }
+}
+
+Image *loadKtx2(Context *context, const void *data, size_t size, Sampler *sampler) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+
+  Ktx2Header header{};
+  if (size < sizeof(header)) throw InvalidUse("KTX2 data is truncated");
+  memcpy(&header, bytes, sizeof(header));
+  if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) throw InvalidUse("Not a KTX2 file");
+  if (header.supercompressionScheme != 0) throw InvalidUse("Supercompressed KTX2 files are not supported");
+  if (header.vkFormat == 0) throw InvalidUse("KTX2 files without a format are not supported");
+  if (header.pixelWidth == 0) throw InvalidUse("KTX2 image has no width");
+  if (header.faceCount != 1 && header.faceCount != 6) throw InvalidUse("KTX2 images have either 1 or 6 faces");
+  if (header.pixelDepth > 0 && header.layerCount > 0) throw InvalidUse("KTX2 3D images cannot have layers");
+
+  // Larger level counts would shift the size by 32 bits or more
+  uint32_t largest   = std::max({ header.pixelWidth, header.pixelHeight, header.pixelDepth });
+  uint32_t maxLevels = 1;
+  while (largest >>= 1) ++maxLevels;
+  if (header.levelCount > maxLevels) throw InvalidUse("KTX2 image has more levels than its full mip chain");
+
+  uint32_t storedLevels = std::max(header.levelCount, 1U);
+  if (size < sizeof(header) + storedLevels * sizeof(Ktx2Level)) throw InvalidUse("KTX2 data is truncated");
+
+  ImageInfo info{};
+  info.width     = header.pixelWidth;
+  info.height    = std::max(header.pixelHeight, 1U);
+  info.format    = ktx2Format(context, header.vkFormat);
+  info.tiling    = ImageTiling::Optimal;
+  info.usage     = { true, false, false, false };
+  info.sampler   = sampler;
+  info.mipLevels = (header.levelCount == 0) ? FULL_MIP_CHAIN : header.levelCount;
+  info.depth     = std::max(header.pixelDepth, 1U);
+  info.layers    = std::max(header.layerCount, 1U);
+
+  if (header.faceCount == 6) info.type = (header.layerCount > 0) ? ImageType::ImageCubeArray : ImageType::ImageCube;
+  else if (header.pixelDepth > 0) info.type = ImageType::Image3D;
+  else if (header.layerCount > 0) info.type = ImageType::Image2DArray;
+  else info.type = ImageType::Image2D;
+
+  Image *image = context->createImage(info);
+
+  try {
+    // Every level, layer, face and slice goes through a single staging buffer and submission
+    std::vector<ImageRegion> regions{};
+    for (uint32_t level = 0; level < storedLevels; ++level) {
+      Ktx2Level index{};
+      memcpy(&index, bytes + sizeof(header) + level * sizeof(Ktx2Level), sizeof(index));
+      if (index.byteOffset > size || index.byteLength > size - index.byteOffset)
+        throw InvalidUse("KTX2 data is truncated");
+
+      size_t width  = std::max<size_t>(info.width >> level, 1);
+      size_t height = std::max<size_t>(info.height >> level, 1);
+      size_t depth  = std::max<size_t>(info.depth >> level, 1);
+
+      // Levels hold every layer, face and slice back to back, each one is copied straight out of the file
+      size_t imageSize  = formatRegionSize(info.format, width, height);
+      size_t imageCount = (info.type == ImageType::Image3D) ? depth : info.layers * header.faceCount;
+      if (imageSize > index.byteLength / imageCount) throw InvalidUse("KTX2 level is smaller than its images");
+
+      for (size_t i = 0; i < imageCount; ++i)
+        regions.push_back(
+            { 0, 0, width, height, static_cast<uint32_t>(i), level, 0, bytes + index.byteOffset + i * imageSize });
+    }
+
+    image->copyRegions(regions.data(), regions.size());
+    if (header.levelCount == 0) image->generateMipmaps();
+  } catch (...) {
+    delete image;
+    throw;
+  }
+
+  return image;
+}
+
+} // namespace purrr
\ No newline at end of file
@@ -0,0 +1,283 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#include "purrr/exceptions.hpp"
+#include "purrr/vulkan/exceptions.hpp"
+
+#include "purrr/vulkan/batchRenderer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace purrr::vulkan {
+
+BatchRenderer::BatchRenderer(Context *context, const BatchRendererInfo &info)
+  : mContext(context), mInfo(info) {
+  if (mInfo.targetCount == 0) throw InvalidUse("Batch renderers require at least one render target");
+  if (mInfo.clearValues.empty()) throw InvalidUse("Batch render targets are always cleared, a clear value is required");
+
+  createTarget(&mTemplate, 1, 1);
+  // Acquired targets are referenced by pointer, the vector must never reallocate
+  mTargets.reserve(mInfo.targetCount);
+
+  // Every batch in flight holds its render targets until it is handed out
+  mBatchSize = std::max<size_t>(mInfo.targetCount / 2, 1);
+  mBatches.resize(mInfo.targetCount / mBatchSize);
+
+  VkCommandBufferAllocateInfo allocateInfo{};
+  allocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocateInfo.pNext              = VK_NULL_HANDLE;
+  allocateInfo.commandPool        = mContext->getCommandPool();
+  allocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocateInfo.commandBufferCount = 1;
+
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fenceInfo.pNext = VK_NULL_HANDLE;
+  fenceInfo.flags = 0;
+
+  for (Batch &batch : mBatches) {
+    expectResult(
+        "Command buffer allocation",
+        vkAllocateCommandBuffers(mContext->getDevice(), &allocateInfo, &batch.commandBuffer));
+    expectResult("Fence creation", vkCreateFence(mContext->getDevice(), &fenceInfo, VK_NULL_HANDLE, &batch.fence));
+  }
+}
+
+BatchRenderer::~BatchRenderer() {
+  for (Batch &batch : mBatches) {
+    if (batch.inFlight)
+      vkWaitForFences(mContext->getDevice(), 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    if (batch.fence) vkDestroyFence(mContext->getDevice(), batch.fence, VK_NULL_HANDLE);
+    if (batch.commandBuffer)
+      vkFreeCommandBuffers(mContext->getDevice(), mContext->getCommandPool(), 1, &batch.commandBuffer);
+  }
+
+  for (Target &target : mTargets) destroyTarget(&target);
+  destroyTarget(&mTemplate);
+}
+
+void BatchRenderer::enqueue(const BatchJob &job) {
+  if (job.width == 0 || job.height == 0) throw InvalidUse("Batch jobs require a non-zero size");
+  mJobs.push_back(job);
+}
+
+bool BatchRenderer::step() {
+  if (!mJobs.empty()) {
+    Batch &batch = mBatches[mNextBatch];
+    // Its render targets are about to be reused, the only place a batch is waited on while jobs are left
+    if (batch.inFlight) deliver(&batch);
+
+    mNextBatch = (mNextBatch + 1) % mBatches.size();
+    submit(&batch);
+    return true;
+  }
+
+  // Nothing left to submit, batches are handed out oldest first
+  for (size_t i = 0; i < mBatches.size(); ++i) {
+    Batch &batch = mBatches[(mNextBatch + i) % mBatches.size()];
+    if (!batch.inFlight) continue;
+
+    deliver(&batch);
+    break;
+  }
+
+  return std::any_of(mBatches.begin(), mBatches.end(), [](const Batch &batch) { return batch.inFlight; });
+}
+
+void BatchRenderer::finish() {
+  while (step());
+}
+
+void BatchRenderer::createTarget(Target *target, size_t width, size_t height) {
+  ImageInfo imageInfo{};
+  imageInfo.width  = width;
+  imageInfo.height = height;
+  imageInfo.format = mInfo.format;
+  imageInfo.tiling = ImageTiling::Optimal;
+  imageInfo.usage  = { false, true, false, false };
+  target->image    = new Image(mContext, imageInfo);
+
+  purrr::Image    *image = target->image;
+  RenderTargetInfo renderTargetInfo{};
+  renderTargetInfo.width      = static_cast<int>(width);
+  renderTargetInfo.height     = static_cast<int>(height);
+  renderTargetInfo.images     = &image;
+  renderTargetInfo.imageCount = 1;
+  target->renderTarget        = new RenderTarget(mContext, renderTargetInfo);
+
+  target->width      = width;
+  target->height     = height;
+  target->pixelsSize = formatRegionSize(mInfo.format, width, height);
+
+  VkBufferCreateInfo createInfo{};
+  createInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.pNext                 = VK_NULL_HANDLE;
+  createInfo.flags                 = 0;
+  createInfo.size                  = target->pixelsSize;
+  createInfo.usage                 = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  createInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+  createInfo.queueFamilyIndexCount = 0;
+  createInfo.pQueueFamilyIndices   = VK_NULL_HANDLE;
+
+  expectResult(
+      "Buffer creation",
+      vkCreateBuffer(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &target->readbackBuffer));
+
+  VkMemoryRequirements memoryRequirements{};
+  vkGetBufferMemoryRequirements(mContext->getDevice(), target->readbackBuffer, &memoryRequirements);
+
+  // Pixels are read on the host once per job, cached memory makes that fast
+  VkMemoryPropertyFlags coherent = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  VkMemoryPropertyFlags cached   = coherent | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+  VkMemoryAllocateInfo allocateInfo{};
+  allocateInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.pNext          = VK_NULL_HANDLE;
+  allocateInfo.allocationSize = memoryRequirements.size;
+  allocateInfo.memoryTypeIndex =
+      mContext->findMemoryType(memoryRequirements.memoryTypeBits, cached, coherent);
+
+  target->readbackMemory = mContext->allocateMemory(allocateInfo);
+  expectResult(
+      "Buffer memory binding",
+      vkBindBufferMemory(mContext->getDevice(), target->readbackBuffer, target->readbackMemory, 0));
+
+  void *mapped = nullptr;
+  expectResult(
+      "Mapping memory",
+      vkMapMemory(mContext->getDevice(), target->readbackMemory, 0, target->pixelsSize, 0, &mapped));
+  target->pixels = reinterpret_cast<const uint8_t *>(mapped);
+}
+
+void BatchRenderer::destroyTarget(Target *target) {
+  if (target->readbackMemory) {
+    vkUnmapMemory(mContext->getDevice(), target->readbackMemory);
+    mContext->freeMemory(target->readbackMemory);
+  }
+  if (target->readbackBuffer) vkDestroyBuffer(mContext->getDevice(), target->readbackBuffer, VK_NULL_HANDLE);
+
+  delete target->renderTarget;
+  delete target->image;
+  *target = {};
+}
+
+BatchRenderer::Target *BatchRenderer::acquireTarget(size_t width, size_t height) {
+  Target *reusable = nullptr;
+  for (Target &target : mTargets) {
+    if (target.busy) continue;
+    if (target.width == width && target.height == height) {
+      target.busy = true;
+      return &target;
+    }
+    if (!reusable) reusable = &target;
+  }
+
+  if (mTargets.size() < mInfo.targetCount) {
+    reusable = &mTargets.emplace_back();
+  } else if (reusable) {
+    // Handed out targets are no longer used by the device
+    destroyTarget(reusable);
+  } else {
+    return nullptr;
+  }
+
+  createTarget(reusable, width, height);
+  reusable->busy = true;
+  return reusable;
+}
+
+void BatchRenderer::submit(Batch *batch) {
+  expectResult("Fence reset", vkResetFences(mContext->getDevice(), 1, &batch->fence));
+  mContext->beginBatch(batch->commandBuffer);
+
+  // Jobs are only popped once the batch was submitted, a throwing job leaves the whole batch queued
+  std::vector<Target *> targets{};
+  bool                  recorded = true;
+  try {
+    while (targets.size() < mBatchSize && targets.size() < mJobs.size()) {
+      BatchJob &job    = mJobs[targets.size()];
+      Target   *target = acquireTarget(job.width, job.height);
+      if (!target) break;
+
+      // The job stays queued when its target cannot be recorded
+      targets.push_back(target);
+      if (!mContext->record(target->renderTarget, { mInfo.clearValues })) {
+        targets.pop_back();
+        target->busy = false;
+        recorded     = false;
+        break;
+      }
+      if (job.record) job.record(mContext);
+      mContext->end();
+
+      VkBufferImageCopy copy{};
+      copy.bufferOffset      = 0;
+      copy.bufferRowLength   = 0;
+      copy.bufferImageHeight = 0;
+      copy.imageSubresource  = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+      copy.imageOffset       = { 0, 0, 0 };
+      copy.imageExtent       = { static_cast<uint32_t>(target->width), static_cast<uint32_t>(target->height), 1 };
+
+      // Fenced with the batch, no readback of its own has to be submitted or waited on
+      target->image->copyToBuffer(batch->commandBuffer, target->readbackBuffer, copy);
+    }
+
+    // Makes the copies visible to the host once the batch fence signals
+    VkMemoryBarrier barrier{};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext         = VK_NULL_HANDLE;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        batch->commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        VK_NULL_HANDLE,
+        0,
+        VK_NULL_HANDLE);
+
+    // Jobs recorded before a failure are still submitted and handed out
+    mContext->submitBatch(batch->fence);
+  } catch (...) {
+    // The fence was reset, the batch must not be waited on. The layouts tracked by the targets no longer match
+    // their images, they are recreated by the next batch.
+    for (Target *target : targets) destroyTarget(target);
+    mContext->abortBatch();
+    throw;
+  }
+  batch->inFlight = true;
+
+  for (Target *target : targets) {
+    batch->jobs.push_back({ target, std::move(mJobs.front().done) });
+    mJobs.pop_front();
+  }
+
+  if (!recorded) throw std::runtime_error("Failed to record a batch render target");
+}
+
+void BatchRenderer::deliver(Batch *batch) {
+  expectResult(
+      "Wait for fence",
+      vkWaitForFences(mContext->getDevice(), 1, &batch->fence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+
+  for (Pending &job : batch->jobs) {
+    std::vector<uint8_t> pixels(job.target->pixels, job.target->pixels + job.target->pixelsSize);
+    job.target->busy = false;
+    if (job.done) job.done(std::move(pixels));
+  }
+
+  batch->jobs.clear();
+  batch->inFlight = false;
+}
+
+} // namespace purrr::vulkan
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
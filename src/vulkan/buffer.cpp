@@ -1,5 +1,7 @@
 #ifdef _PURRR_BACKEND_VULKAN
 
+#include "purrr/exceptions.hpp"
+
 #include "purrr/vulkan/exceptions.hpp"
 
 #include "purrr/vulkan/buffer.hpp"
@@ -11,7 +13,7 @@ namespace purrr::vulkan {
 
 Buffer::Buffer(Context *context, const BufferInfo &info)
   : mContext(context), mSize(info.size), mType(info.type) {
-  VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
   VkDescriptorType      descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
   VkDescriptorSetLayout layout         = VK_NULL_HANDLE;
@@ -36,6 +38,7 @@ Buffer::Buffer(Context *context, const BufferInfo &info)
   }
 
   createBuffer(mContext, info.size, usage, true, &mBuffer, &mMemory);
+  mContext->setObjectName(VK_OBJECT_TYPE_BUFFER, reinterpret_cast<uint64_t>(mBuffer), info.name);
   if (layout != VK_NULL_HANDLE) {
     allocateDescriptorSet(descriptorType, layout);
   }
@@ -43,14 +46,18 @@ Buffer::Buffer(Context *context, const BufferInfo &info)
 
 Buffer::~Buffer() {
   if (mDescriptorSet) vkFreeDescriptorSets(mContext->getDevice(), mContext->getDescriptorPool(), 1, &mDescriptorSet);
-  if (mMemory) vkFreeMemory(mContext->getDevice(), mMemory, VK_NULL_HANDLE);
+  if (mMemory) mContext->freeMemory(mMemory);
   if (mBuffer) vkDestroyBuffer(mContext->getDevice(), mBuffer, VK_NULL_HANDLE);
 }
 
 void Buffer::copy(const void *data, size_t offset, size_t size) {
+  TraceSpan span(mContext->getTracer(), "Buffer upload");
+
   VkBuffer       stagingBuffer = VK_NULL_HANDLE;
   VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
   createBuffer(mContext, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false, &stagingBuffer, &stagingMemory);
+  mContext->getCurrentStats().stagingAllocations += 1;
+  mContext->getCurrentStats().bytesUploaded      += size;
 
   void *stagingData = nullptr;
   expectResult("Mapping memory", vkMapMemory(mContext->getDevice(), stagingMemory, 0, size, 0, &stagingData));
@@ -67,10 +74,42 @@ void Buffer::copy(const void *data, size_t offset, size_t size) {
 
   mContext->submitSingleTimeCommands(commandBuffer);
 
-  vkFreeMemory(mContext->getDevice(), stagingMemory, VK_NULL_HANDLE);
+  mContext->freeMemory(stagingMemory);
   vkDestroyBuffer(mContext->getDevice(), stagingBuffer, VK_NULL_HANDLE);
 }
 
+std::future<std::vector<uint8_t>> Buffer::readback(size_t offset, size_t size) {
+  if (offset + size > mSize) throw InvalidUse("Read range is outside of the buffer");
+
+  return mContext->getReadbackRing()->read(
+      size, 4, [this, offset, size](VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset) {
+        // Buffers have no tracked state, so any earlier write on the queue is waited for
+        VkMemoryBarrier barrier{};
+        barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.pNext         = VK_NULL_HANDLE;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            VK_NULL_HANDLE,
+            0,
+            VK_NULL_HANDLE);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = offset;
+        copyRegion.dstOffset = bufferOffset;
+        copyRegion.size      = size;
+        vkCmdCopyBuffer(commandBuffer, mBuffer, buffer, 1, &copyRegion);
+      });
+}
+
 void Buffer::allocateDescriptorSet(VkDescriptorType type, VkDescriptorSetLayout layout) {
   VkDescriptorSetAllocateInfo allocateInfo{};
   allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -135,7 +174,7 @@ void Buffer::createBuffer(
   allocateInfo.allocationSize  = memoryRequirements.size;
   allocateInfo.memoryTypeIndex = context->findMemoryType(memoryRequirements.memoryTypeBits, memoryProperties);
 
-  expectResult("Memory allocation", vkAllocateMemory(context->getDevice(), &allocateInfo, nullptr, memory));
+  *memory = context->allocateMemory(allocateInfo);
 
   vkBindBufferMemory(context->getDevice(), *buffer, *memory, 0);
 }
@@ -11,10 +11,19 @@
 #include "purrr/vulkan/sampler.hpp"
 #include "purrr/vulkan/image.hpp"
 #include "purrr/vulkan/renderTarget.hpp"
+#include "purrr/vulkan/renderGraph.hpp"
+#include "purrr/vulkan/batchRenderer.hpp"
+#include "purrr/vulkan/query.hpp"
+#include "purrr/vulkan/tracer.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <iostream>
 #include <limits>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <array>
 #include <unordered_set>
@@ -23,6 +32,9 @@
 
 namespace purrr::vulkan {
 
+// Clear values are handed to Vulkan without conversion
+static_assert(sizeof(ContextClearValue) == sizeof(VkClearValue));
+
 VkIndexType vkIndexType(IndexType type) {
   switch (type) {
   case IndexType::U16: return VK_INDEX_TYPE_UINT16;
@@ -33,21 +45,79 @@ VkIndexType vkIndexType(IndexType type) {
 }
 
 Context::Context(const ContextInfo &info)
-  : purrr::platform::Context(info) {
-  std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+  : purrr::platform::Context(info), mDebug(info.debug), mHeadless(info.headless), mDebugCallback(info.debugCallback) {
+  std::vector<const char *> deviceExtensions{};
+  if (!mHeadless) deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
+  double start = getTime();
   createInstance(info);
-  chooseDevice(deviceExtensions);
+  createDebugMessenger();
+  double instanceCreated = getTime();
+  chooseDevice(deviceExtensions, info.device);
+  double deviceChosen = getTime();
+
+  // Devices without dynamic rendering keep using render passes
+  std::vector<const char *> dynamicRenderingExtensions = { VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+                                                           VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+                                                           VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME };
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(mPhysicalDevice, &properties);
+  mDynamicRendering = info.dynamicRendering && properties.apiVersion >= Version(1, 1) &&
+                      deviceExtensionsPresent(mPhysicalDevice, dynamicRenderingExtensions);
+  if (mDynamicRendering)
+    for (const char *extension : dynamicRenderingExtensions) deviceExtensions.push_back(extension);
+
+  std::vector<const char *> presentWaitExtensions = { VK_KHR_PRESENT_ID_EXTENSION_NAME,
+                                                      VK_KHR_PRESENT_WAIT_EXTENSION_NAME };
+  mPresentWait = info.presentWait && !mHeadless && properties.apiVersion >= Version(1, 1) &&
+                 deviceExtensionsPresent(mPhysicalDevice, presentWaitExtensions) && presentWaitSupported();
+  if (mPresentWait)
+    for (const char *extension : presentWaitExtensions) deviceExtensions.push_back(extension);
+
+  // Devices supporting the extension have to support the feature
+  mConditionalRendering = deviceExtensionsPresent(mPhysicalDevice, { VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME });
+  if (mConditionalRendering) deviceExtensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+
+  mMemoryBudget = info.memoryBudget && properties.apiVersion >= Version(1, 1) &&
+                  deviceExtensionsPresent(mPhysicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+  if (mMemoryBudget) deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &mMemoryProperties);
+
+  // Lets traces place GPU scopes on the CPU timeline
+  mCalibratedTimestamps =
+      info.gpuProfiling && deviceExtensionsPresent(mPhysicalDevice, { VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME });
+  if (mCalibratedTimestamps) deviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+
   createDevice(deviceExtensions);
-  getQueue();
+  loadFunctions();
+  mDeviceExtensions.clear();
+  double deviceCreated = getTime();
+
+  retrieveQueue();
   createCommandPool();
   allocateCommandBuffer();
   createFence();
-  createDescriptorSetLayouts();
-  createDescriptorPool();
+
+  if (info.gpuProfiling && GpuProfiler::timestampBits(mPhysicalDevice, mQueueFamilyIndex) > 0)
+    mProfiler = new GpuProfiler(this);
+
+  double end = getTime();
+
+  mStartupStats.platform        = getPlatformStartupTime();
+  mStartupStats.instance        = instanceCreated - start;
+  mStartupStats.deviceSelection = deviceChosen - instanceCreated;
+  mStartupStats.device          = deviceCreated - deviceChosen;
+  mStartupStats.resources       = end - deviceCreated;
+  mStartupStats.total           = mStartupStats.platform + end - start;
 }
 
 Context::~Context() {
+  delete mReadbackRing;
+  delete mProfiler;
+  delete mTracer;
+
+  if (mInputDescriptorSetLayout != VK_NULL_HANDLE)
+    vkDestroyDescriptorSetLayout(mDevice, mInputDescriptorSetLayout, VK_NULL_HANDLE);
   if (mStorageDescriptorSetLayout != VK_NULL_HANDLE)
     vkDestroyDescriptorSetLayout(mDevice, mStorageDescriptorSetLayout, VK_NULL_HANDLE);
   if (mUniformDescriptorSetLayout != VK_NULL_HANDLE)
@@ -61,10 +131,17 @@ Context::~Context() {
   if (mCommandPool != VK_NULL_HANDLE) vkDestroyCommandPool(mDevice, mCommandPool, VK_NULL_HANDLE);
 
   if (mDevice != VK_NULL_HANDLE) vkDestroyDevice(mDevice, VK_NULL_HANDLE);
+
+  if (mDebugMessenger != VK_NULL_HANDLE) {
+    auto destroyDebugUtilsMessenger = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+        vkGetInstanceProcAddr(mInstance, "vkDestroyDebugUtilsMessengerEXT"));
+    destroyDebugUtilsMessenger(mInstance, mDebugMessenger, VK_NULL_HANDLE);
+  }
   if (mInstance != VK_NULL_HANDLE) vkDestroyInstance(mInstance, VK_NULL_HANDLE);
 }
 
 purrr::Window *Context::createWindow(const WindowInfo &info) {
+  if (mHeadless) throw InvalidUse("Headless contexts cannot create windows");
   return new Window(this, info);
 }
 
@@ -88,6 +165,18 @@ purrr::RenderTarget *Context::createRenderTarget(const RenderTargetInfo &info) {
   return new RenderTarget(this, info);
 }
 
+purrr::RenderGraph *Context::createRenderGraph() {
+  return new RenderGraph(this);
+}
+
+purrr::BatchRenderer *Context::createBatchRenderer(const BatchRendererInfo &info) {
+  return new BatchRenderer(this, info);
+}
+
+purrr::Query *Context::createQuery(QueryType type) {
+  return new Query(this, type);
+}
+
 purrr::Shader *Context::createShader(ShaderType type, const std::vector<char> &code) {
   return new Shader(this, { type, code.data(), code.size() });
 }
@@ -97,8 +186,14 @@ purrr::Shader *Context::createShader(ShaderType type, const std::string_view &co
 }
 
 void Context::begin() {
-  expectResult("Wait for fence", vkWaitForFences(mDevice, 1, &mFence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+  TraceSpan span(mTracer, "begin");
+  waitForFence();
   expectResult("Fence reset", vkResetFences(mDevice, 1, &mFence));
+  ++mFrameIndex;
+
+  if (mReadbackRing) mReadbackRing->poll();
+  // Catches other processes eating into the budget
+  if (mMemoryCallback) checkMemoryThreshold();
 
   expectResult("Command buffer reset", vkResetCommandBuffer(mCommandBuffer, 0));
 
@@ -109,26 +204,41 @@ void Context::begin() {
   beginInfo.pInheritanceInfo = VK_NULL_HANDLE;
 
   expectResult("Command buffer begin", vkBeginCommandBuffer(mCommandBuffer, &beginInfo));
+  mFrameOpen = true;
+
+  if (mProfiler) {
+    bool collected = mProfiler->beginFrame(mCommandBuffer, mFrameIndex);
+    if (collected && mTracer) mTracer->addGpuFrame(*mProfiler);
+  }
 }
 
 bool Context::record(purrr::Window *window, const RecordClear &clear) {
   if (window->api() != api()) return false;
   // TODO: Introduce InvalidUse exception
   if (mRecording) throw InvalidUse("Cannot record before calling end()");
+  if (mTracer) mRecordStart = mTracer->now();
 
   Window *vkWindow = reinterpret_cast<Window *>(window);
   if (!vkWindow->sameContext(this)) return false;
+  if (clear.clearValues.empty()) throw InvalidUse("Windows are always cleared, a clear value is required");
+
+  vkWindow->destroyRetired();
 
   uint32_t imageIndex = 0;
   VkResult result     = VK_SUCCESS;
 
-  result = vkAcquireNextImageKHR(
-      mDevice,
-      vkWindow->getSwapchain(),
-      std::numeric_limits<uint64_t>::max(),
-      vkWindow->getImageSemaphore(),
-      VK_NULL_HANDLE,
-      &imageIndex);
+  {
+    TraceSpan acquire(mTracer, "Acquire");
+    double    start = getTime();
+    result          = vkAcquireNextImageKHR(
+        mDevice,
+        vkWindow->getSwapchain(),
+        std::numeric_limits<uint64_t>::max(),
+        vkWindow->getImageSemaphore(),
+        VK_NULL_HANDLE,
+        &imageIndex);
+    mStats.acquireTime += getTime() - start;
+  }
 
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
     mRecreateQueue.push(vkWindow);
@@ -136,29 +246,77 @@ bool Context::record(purrr::Window *window, const RecordClear &clear) {
   } else if (result != VK_SUBOPTIMAL_KHR)
     expectResult("Next image acquire", result);
 
-  mRecording = true;
+  if (mProfiler) {
+    mRecordScope = mProfiler->getOpenScopeCount();
+    mProfiler->beginScope(mCommandBuffer, "Window");
+  }
+  beginLabel("Window");
+
+  mRecording    = true;
+  mRenderTarget = vkWindow;
+  mSubpass      = 0;
   mWindows.push_back(vkWindow);
   mSwapchains.push_back(vkWindow->getSwapchain());
   mImageIndices.push_back(imageIndex);
   mImageSemaphores.push_back(vkWindow->getImageSemaphore());
   mSubmitSemaphores.push_back(vkWindow->getSubmitSemaphores()[imageIndex]);
 
-  std::vector<VkClearValue> clearValues{};
-  for (const ContextClearValue &value : clear.clearValues) {
-    clearValues.push_back(*reinterpret_cast<const VkClearValue *>(&value));
+  VkRect2D renderArea = { {}, vkWindow->getSwapchainExtent() };
+
+  if (mDynamicRendering) {
+    mPresentImage = vkWindow->getImages()[imageIndex];
+
+    // Waits on the same stage as the image semaphore, so the transition happens after the acquire
+    VkImageMemoryBarrier barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext               = VK_NULL_HANDLE;
+    barrier.srcAccessMask       = 0;
+    barrier.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout           = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image               = mPresentImage;
+    barrier.subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    vkCmdPipelineBarrier(
+        mCommandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0,
+        0,
+        VK_NULL_HANDLE,
+        0,
+        VK_NULL_HANDLE,
+        1,
+        &barrier);
+
+    std::vector<VkRenderingAttachmentInfoKHR> attachments(1);
+    attachments[0].sType              = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    attachments[0].pNext              = VK_NULL_HANDLE;
+    attachments[0].imageView          = vkWindow->getImageViews()[imageIndex];
+    attachments[0].imageLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[0].resolveMode        = VK_RESOLVE_MODE_NONE;
+    attachments[0].resolveImageView   = VK_NULL_HANDLE;
+    attachments[0].resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].loadOp             = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp            = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].clearValue         = *reinterpret_cast<const VkClearValue *>(&clear.clearValues[0]);
+
+    beginRendering(renderArea, attachments);
+  } else {
+    VkRenderPassBeginInfo renderPassBeginInfo{};
+    renderPassBeginInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext           = VK_NULL_HANDLE;
+    renderPassBeginInfo.renderPass      = vkWindow->getRenderPass();
+    renderPassBeginInfo.framebuffer     = vkWindow->getFramebuffers()[imageIndex];
+    renderPassBeginInfo.renderArea      = renderArea;
+    renderPassBeginInfo.clearValueCount = 1;
+    renderPassBeginInfo.pClearValues    = reinterpret_cast<const VkClearValue *>(clear.clearValues.data());
+
+    vkCmdBeginRenderPass(mCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
   }
 
-  VkRenderPassBeginInfo renderPassBeginInfo{};
-  renderPassBeginInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassBeginInfo.pNext           = VK_NULL_HANDLE;
-  renderPassBeginInfo.renderPass      = vkWindow->getRenderPass();
-  renderPassBeginInfo.framebuffer     = vkWindow->getFramebuffers()[imageIndex];
-  renderPassBeginInfo.renderArea      = { {}, vkWindow->getSwapchainExtent() };
-  renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-  renderPassBeginInfo.pClearValues    = clearValues.data();
-
-  vkCmdBeginRenderPass(mCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
   auto size = vkWindow->getSize();
 
   VkViewport viewport{};
@@ -170,7 +328,7 @@ bool Context::record(purrr::Window *window, const RecordClear &clear) {
   viewport.maxDepth = 1.0f;
 
   vkCmdSetViewport(mCommandBuffer, 0, 1, &viewport);
-  vkCmdSetScissor(mCommandBuffer, 0, 1, &renderPassBeginInfo.renderArea);
+  vkCmdSetScissor(mCommandBuffer, 0, 1, &renderArea);
 
   return true;
 }
@@ -179,29 +337,81 @@ bool Context::record(purrr::RenderTarget *target, const RecordClear &clear) {
   if (target->api() != api()) return false;
   // TODO: Introduce InvalidUse exception
   if (mRecording) throw InvalidUse("Cannot record before calling end()");
+  if (mTracer) mRecordStart = mTracer->now();
 
   RenderTarget *vkTarget = reinterpret_cast<RenderTarget *>(target);
   if (!vkTarget->sameContext(this)) return false;
+  if (clear.clearValues.size() < vkTarget->getClearValueCount())
+    throw InvalidUse("Every cleared attachment requires a clear value");
 
-  mRecording = true;
+  bool dynamic = vkTarget->getRenderPass() == VK_NULL_HANDLE;
+  if (!dynamic && vkTarget->getFramebuffer() == VK_NULL_HANDLE) vkTarget->createFramebuffer();
 
-  std::vector<VkClearValue> clearValues{};
-  for (const ContextClearValue &value : clear.clearValues) {
-    clearValues.push_back(*reinterpret_cast<const VkClearValue *>(&value));
+  if (mProfiler) {
+    mRecordScope = mProfiler->getOpenScopeCount();
+    mProfiler->beginScope(mCommandBuffer, "RenderTarget");
   }
+  beginLabel(vkTarget->getName().empty() ? "RenderTarget" : vkTarget->getName().c_str());
+
+  std::vector<VkImageMemoryBarrier> barriers{};
+  VkPipelineStageFlags              srcStage = 0;
+  vkTarget->prepareAttachments(&barriers, &srcStage);
+  if (!barriers.empty())
+    vkCmdPipelineBarrier(
+        mCommandBuffer,
+        srcStage,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0,
+        0,
+        VK_NULL_HANDLE,
+        0,
+        VK_NULL_HANDLE,
+        static_cast<uint32_t>(barriers.size()),
+        barriers.data());
+
+  mRecording    = true;
+  mRenderTarget = vkTarget;
+  mSubpass      = 0;
+
+  auto     size       = vkTarget->getSize();
+  VkRect2D renderArea = { {}, { static_cast<uint32_t>(size.first), static_cast<uint32_t>(size.second) } };
+
+  if (dynamic) {
+    const std::vector<Image *> &images   = vkTarget->getImages();
+    const std::vector<LoadOp>  &loadOps  = vkTarget->getLoadOps();
+    const std::vector<StoreOp> &storeOps = vkTarget->getStoreOps();
+
+    std::vector<VkRenderingAttachmentInfoKHR> attachments(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+      if (images[i]->getImageView() == VK_NULL_HANDLE) throw InvalidUse("Render target images have no memory bound");
+
+      attachments[i].sType              = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+      attachments[i].pNext              = VK_NULL_HANDLE;
+      attachments[i].imageView          = images[i]->getAttachmentView();
+      attachments[i].imageLayout        = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      attachments[i].resolveMode        = VK_RESOLVE_MODE_NONE;
+      attachments[i].resolveImageView   = VK_NULL_HANDLE;
+      attachments[i].resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      attachments[i].loadOp             = vkLoadOp(loadOps[i]);
+      attachments[i].storeOp            = vkStoreOp(storeOps[i]);
+      attachments[i].clearValue         = {};
+      if (loadOps[i] == LoadOp::Clear)
+        attachments[i].clearValue = *reinterpret_cast<const VkClearValue *>(&clear.clearValues[i]);
+    }
 
-  auto size = vkTarget->getSize();
-
-  VkRenderPassBeginInfo renderPassBeginInfo{};
-  renderPassBeginInfo.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassBeginInfo.pNext       = VK_NULL_HANDLE;
-  renderPassBeginInfo.renderPass  = vkTarget->getRenderPass();
-  renderPassBeginInfo.framebuffer = vkTarget->getFramebuffer();
-  renderPassBeginInfo.renderArea  = { {}, { static_cast<uint32_t>(size.first), static_cast<uint32_t>(size.second) } };
-  renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-  renderPassBeginInfo.pClearValues    = clearValues.data();
-
-  vkCmdBeginRenderPass(mCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    beginRendering(renderArea, attachments);
+  } else {
+    VkRenderPassBeginInfo renderPassBeginInfo{};
+    renderPassBeginInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.pNext           = VK_NULL_HANDLE;
+    renderPassBeginInfo.renderPass      = vkTarget->getRenderPass();
+    renderPassBeginInfo.framebuffer     = vkTarget->getFramebuffer();
+    renderPassBeginInfo.renderArea      = renderArea;
+    renderPassBeginInfo.clearValueCount = vkTarget->getClearValueCount();
+    renderPassBeginInfo.pClearValues    = reinterpret_cast<const VkClearValue *>(clear.clearValues.data());
+
+    vkCmdBeginRenderPass(mCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+  }
 
   VkViewport viewport{};
   viewport.x        = 0.0f;
@@ -212,20 +422,31 @@ bool Context::record(purrr::RenderTarget *target, const RecordClear &clear) {
   viewport.maxDepth = 1.0f;
 
   vkCmdSetViewport(mCommandBuffer, 0, 1, &viewport);
-  vkCmdSetScissor(mCommandBuffer, 0, 1, &renderPassBeginInfo.renderArea);
+  vkCmdSetScissor(mCommandBuffer, 0, 1, &renderArea);
 
   return true;
 }
 
+void Context::nextSubpass() {
+  if (!mRecording) throw InvalidUse("nextSubpass() called before record()");
+  if (mSubpass + 1 >= mRenderTarget->getSubpassCount()) throw InvalidUse("Render target has no further subpasses");
+
+  ++mSubpass;
+  mProgram = nullptr;
+  vkCmdNextSubpass(mCommandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+}
+
 void Context::useProgram(purrr::Program *program) {
   if (!mRecording) throw InvalidUse("useProgram() called before record()");
 
   if (program->api() != Api::Vulkan) throw InvalidUse("Uncompatible program object");
   Program *vkProgram = reinterpret_cast<Program *>(program);
-  if (!vkProgram->sameRenderTarget(mWindows.back())) throw InvalidUse("Uncompatible program object");
+  if (!vkProgram->compatibleWith(mRenderTarget)) throw InvalidUse("Uncompatible program object");
+  if (vkProgram->getSubpass() != mSubpass) throw InvalidUse("Program was created for a different subpass");
   mProgram = vkProgram;
 
   vkCmdBindPipeline(mCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkProgram->getPipeline());
+  ++mStats.pipelineBinds;
 }
 
 void Context::useVertexBuffer(purrr::Buffer *buffer, uint32_t index) {
@@ -238,6 +459,7 @@ void Context::useVertexBuffer(purrr::Buffer *buffer, uint32_t index) {
   VkBuffer     buffers[1] = { vkBuffer->getBuffer() };
   VkDeviceSize offsets[1] = { 0 };
   vkCmdBindVertexBuffers(mCommandBuffer, index, 1, buffers, offsets);
+  ++mStats.vertexBufferBinds;
 }
 
 void Context::useIndexBuffer(purrr::Buffer *buffer, IndexType type) {
@@ -248,6 +470,7 @@ void Context::useIndexBuffer(purrr::Buffer *buffer, IndexType type) {
   if (vkBuffer->getType() != BufferType::Index) throw InvalidUse("Uncompatible buffer object");
 
   vkCmdBindIndexBuffer(mCommandBuffer, vkBuffer->getBuffer(), 0, vkIndexType(type));
+  ++mStats.indexBufferBinds;
 }
 
 void Context::useUniformBuffer(purrr::Buffer *buffer, uint32_t index) {
@@ -267,6 +490,7 @@ void Context::useUniformBuffer(purrr::Buffer *buffer, uint32_t index) {
       sets,
       0,
       VK_NULL_HANDLE);
+  ++mStats.descriptorBinds;
 }
 
 void Context::useStorageBuffer(purrr::Buffer *buffer, uint32_t index) {
@@ -286,6 +510,7 @@ void Context::useStorageBuffer(purrr::Buffer *buffer, uint32_t index) {
       sets,
       0,
       VK_NULL_HANDLE);
+  ++mStats.descriptorBinds;
 }
 
 void Context::useTextureImage(purrr::Image *image, uint32_t index) {
@@ -306,29 +531,113 @@ void Context::useTextureImage(purrr::Image *image, uint32_t index) {
       sets,
       0,
       VK_NULL_HANDLE);
+  ++mStats.descriptorBinds;
+}
+
+void Context::useInputAttachment(purrr::Image *image, uint32_t index) {
+  if (!mRecording) throw InvalidUse("useInputAttachment() called before record()");
+  if (!mProgram) throw InvalidUse("useInputAttachment() called before useProgram()");
+
+  if (image->api() != Api::Vulkan) throw InvalidUse("Uncompatible image object");
+  Image *vkImage = reinterpret_cast<Image *>(image);
+  if (!vkImage->getUsage().inputAttachment) throw InvalidUse("Uncompatible image object");
+
+  VkDescriptorSet sets[1] = { vkImage->getInputDescriptorSet() };
+  vkCmdBindDescriptorSets(
+      mCommandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      mProgram->getLayout(),
+      index,
+      1,
+      sets,
+      0,
+      VK_NULL_HANDLE);
+  ++mStats.descriptorBinds;
 }
 
 void Context::draw(size_t vertexCount, size_t instanceCount) {
   if (!mRecording) throw InvalidUse("draw() called before record()");
 
   vkCmdDraw(mCommandBuffer, static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(instanceCount), 0, 0);
+  ++mStats.draws;
 }
 
 void Context::drawIndexed(size_t indexCount, size_t instanceCount) {
   if (!mRecording) throw InvalidUse("draw() called before record()");
 
   vkCmdDrawIndexed(mCommandBuffer, static_cast<uint32_t>(indexCount), static_cast<uint32_t>(instanceCount), 0, 0, 0);
+  ++mStats.draws;
 }
 
 void Context::end() {
   if (!mRecording) throw InvalidUse("end() called before record()");
+  if (mProfiler && mProfiler->getOpenScopeCount() != mRecordScope + 1)
+    throw InvalidUse("Scopes begun after record() have to end before end()");
+  for (Query *query : mRecordQueries)
+    if (query->isActive()) throw InvalidUse("Queries begun after record() have to end before end()");
+  if (mConditional && mRecordConditional)
+    throw InvalidUse("Conditional rendering begun after record() has to end before end()");
   mRecording = false;
-  vkCmdEndRenderPass(mCommandBuffer);
+
+  if (mRenderTarget->getRenderPass() != VK_NULL_HANDLE) {
+    vkCmdEndRenderPass(mCommandBuffer);
+  } else {
+    mCmdEndRendering(mCommandBuffer);
+    if (mPresentImage != VK_NULL_HANDLE) transitionPresentImage();
+  }
+
+  // Copies are not allowed inside render passes
+  for (Query *query : mRecordQueries) query->copyResults(mCommandBuffer);
+  mRecordQueries.clear();
+
+  endLabel();
+  if (mProfiler) mProfiler->endScope(mCommandBuffer);
+  if (mTracer) mTracer->addCpuSpan("record", mRecordStart, mTracer->now());
+}
+
+void Context::waitForFence() {
+  TraceSpan span(mTracer, "Wait for fence");
+  double    start = getTime();
+  expectResult("Wait for fence", vkWaitForFences(mDevice, 1, &mFence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+  mStats.fenceWaitTime += getTime() - start;
+}
+
+void Context::transitionPresentImage() {
+  // Render passes do this through the final layout of the window attachment
+  VkImageMemoryBarrier barrier{};
+  barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.pNext               = VK_NULL_HANDLE;
+  barrier.srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barrier.dstAccessMask       = 0;
+  barrier.oldLayout           = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  barrier.newLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image               = mPresentImage;
+  barrier.subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+  vkCmdPipelineBarrier(
+      mCommandBuffer,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0,
+      VK_NULL_HANDLE,
+      0,
+      VK_NULL_HANDLE,
+      1,
+      &barrier);
+
+  mPresentImage = VK_NULL_HANDLE;
 }
 
 void Context::submit() {
+  TraceSpan span(mTracer, "submit");
   vkEndCommandBuffer(mCommandBuffer);
   if (mRecording) throw InvalidUse("Cannot submit while recording");
+  if (mProfiler && mProfiler->getOpenScopeCount() > 0) throw InvalidUse("Every scope has to end before submit()");
+  if (mOpenQueries > 0) throw InvalidUse("Every query has to end before submit()");
+  if (mConditional) throw InvalidUse("Conditional rendering has to end before submit()");
 
   std::vector<VkPipelineStageFlags> stageMasks(mImageSemaphores.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
@@ -343,10 +652,17 @@ void Context::submit() {
   submitInfo.signalSemaphoreCount = static_cast<uint32_t>(mSubmitSemaphores.size());
   submitInfo.pSignalSemaphores    = mSubmitSemaphores.data();
 
+  if (mTracer) mTracer->addSubmit(mFrameIndex, mTracer->now());
   expectResult("Queue submition", vkQueueSubmit(mQueue, 1, &submitInfo, mFence));
+  mFrameOpen = false;
+
+  ++mStats.submits;
+  mFrameStats = mStats;
+  mStats      = {};
 }
 
 void Context::present(bool preventSpinning) {
+  TraceSpan span(mTracer, "present");
   if (mRecording) throw InvalidUse("Cannot present while recording");
 
   std::vector<VkResult> results(mSwapchains.size(), VK_SUCCESS);
@@ -361,6 +677,16 @@ void Context::present(bool preventSpinning) {
   presentInfo.pImageIndices      = mImageIndices.data();
   presentInfo.pResults           = results.data();
 
+  std::vector<uint64_t> presentIds(mWindows.size());
+  for (size_t i = 0; i < mWindows.size(); ++i) presentIds[i] = mWindows[i]->nextPresentId();
+
+  VkPresentIdKHR presentIdInfo{};
+  presentIdInfo.sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+  presentIdInfo.pNext          = VK_NULL_HANDLE;
+  presentIdInfo.swapchainCount = static_cast<uint32_t>(presentIds.size());
+  presentIdInfo.pPresentIds    = presentIds.data();
+  if (mPresentWait) presentInfo.pNext = &presentIdInfo;
+
   if (!mSwapchains.empty()) {
     VkResult result = vkQueuePresentKHR(mQueue, &presentInfo);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
@@ -377,11 +703,10 @@ void Context::present(bool preventSpinning) {
   }
 
   if (!mRecreateQueue.empty()) {
-    vkDeviceWaitIdle(mDevice);
-
+    // Old swapchains are retired by the windows, nothing has to wait for the device here
     std::queue<Window *> recreateQueue = {};
     while (!mRecreateQueue.empty()) {
-      Window *window = mRecreateQueue.back();
+      Window *window = mRecreateQueue.front();
       mRecreateQueue.pop();
       if (!window->recreateSwapchain()) recreateQueue.push(window);
     }
@@ -391,6 +716,18 @@ void Context::present(bool preventSpinning) {
     if (!mRecreateQueue.empty() && mWindows.empty() && preventSpinning) waitForWindowEvents();
   }
 
+  // Recreated swapchains start counting from zero again
+  mLastPresents.clear();
+  for (size_t i = 0; i < mWindows.size(); ++i)
+    if (mWindows[i]->getSwapchain() == mSwapchains[i]) mLastPresents.emplace_back(mSwapchains[i], presentIds[i]);
+
+  if (mTargetFrameTime > 0.0) {
+    double now = getTime();
+    if (mFrameStart > 0.0) mFrameWork = mFrameWork * 0.9 + (now - mFrameStart) * 0.1;
+    // A missed deadline restarts the schedule instead of rushing to catch up
+    mFrameDeadline = std::max(mFrameDeadline + mTargetFrameTime, now);
+  }
+
   mWindows.clear();
   mSwapchains.clear();
   mImageIndices.clear();
@@ -402,49 +739,175 @@ void Context::waitIdle() {
   expectResult("Wait idle", vkDeviceWaitIdle(mDevice));
 }
 
-void Context::createInstance(const ContextInfo &info) {
-  std::vector<const char *> layers{};
-  std::vector<const char *> extensions{};
+void Context::setTargetFrameTime(double seconds) {
+  mTargetFrameTime = seconds;
+  mFrameDeadline   = getTime();
+}
 
-  appendRequiredVulkanExtensions(extensions);
+void Context::waitForNextFrame() {
+  // begin() finds the fence signaled and no longer blocks after input was polled
+  waitForFence();
 
-  if (info.debug) {
-    layers.push_back("VK_LAYER_KHRONOS_validation");
-    extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+  if (mPresentWait) {
+    for (auto [swapchain, presentId] : mLastPresents) {
+      VkResult result = mWaitForPresent(mDevice, swapchain, presentId, PRESENT_WAIT_TIMEOUT);
+      if (result != VK_TIMEOUT && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR)
+        expectResult("Present wait", result);
+    }
+    mLastPresents.clear();
   }
 
-  { // Check if every required layer is present
-    uint32_t count = 0;
-    expectResult("Instance layer enumeration", vkEnumerateInstanceLayerProperties(&count, VK_NULL_HANDLE));
+  if (mTargetFrameTime > 0.0) {
+    // Wake up early enough for the rest of the frame to end right at the deadline
+    double wakeUp = mFrameDeadline - mFrameWork;
+    double now    = getTime();
+    if (wakeUp - now > SLEEP_GRANULARITY)
+      std::this_thread::sleep_for(std::chrono::duration<double>(wakeUp - now - SLEEP_GRANULARITY));
+    while (getTime() < wakeUp) std::this_thread::yield();
+  }
+
+  mFrameStart = getTime();
+}
 
-    std::vector<VkLayerProperties> availableLayers(count);
-    expectResult("Instance layer enumeration", vkEnumerateInstanceLayerProperties(&count, availableLayers.data()));
+void Context::beginScope(const char *name) {
+  if (mProfiler) mProfiler->beginScope(mCommandBuffer, name);
+  beginLabel(name);
+}
 
-    std::unordered_set<std::string_view> requiredLayers(layers.begin(), layers.end());
-    for (const VkLayerProperties &layer : availableLayers) {
-      requiredLayers.erase(layer.layerName);
-    }
+void Context::endScope() {
+  if (mProfiler) {
+    if (mProfiler->getOpenScopeCount() == 0) throw InvalidUse("endScope() called without beginScope()");
+    if (mRecording && mProfiler->getOpenScopeCount() == mRecordScope + 1)
+      throw InvalidUse("endScope() would end the scope of record()");
 
-    if (!requiredLayers.empty()) throw NotPresent("layers", requiredLayers);
+    mProfiler->endScope(mCommandBuffer);
   }
+  endLabel();
+}
 
-  { // Check if every required extension is present
-    uint32_t count = 0;
-    expectResult(
-        "Instance extension enumeration",
-        vkEnumerateInstanceExtensionProperties(VK_NULL_HANDLE, &count, VK_NULL_HANDLE));
+std::vector<GpuTiming> Context::getGpuTimings() const {
+  if (!mProfiler) return {};
+  return mProfiler->getTimings();
+}
 
-    std::vector<VkExtensionProperties> availableExtensions(count);
-    expectResult(
-        "Instance extension enumeration",
-        vkEnumerateInstanceExtensionProperties(VK_NULL_HANDLE, &count, availableExtensions.data()));
+MemoryStats Context::getMemoryStats() const {
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+  budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  budget.pNext = VK_NULL_HANDLE;
+
+  VkPhysicalDeviceMemoryProperties2 properties{};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  properties.pNext = &budget;
+  if (mMemoryBudget) vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice, &properties);
+
+  MemoryStats stats{};
+  for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i) {
+    const VkMemoryHeap &heap = mMemoryProperties.memoryHeaps[i];
+
+    MemoryHeapStats heapStats{};
+    heapStats.size        = heap.size;
+    heapStats.allocated   = mHeapAllocated[i];
+    heapStats.usage       = mMemoryBudget ? budget.heapUsage[i] : mHeapAllocated[i];
+    heapStats.budget      = mMemoryBudget ? budget.heapBudget[i] : heap.size;
+    heapStats.deviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    stats.heaps.push_back(heapStats);
+  }
 
-    std::unordered_set<std::string_view> requiredExtensions(extensions.begin(), extensions.end());
-    for (const VkExtensionProperties &extension : availableExtensions) {
-      requiredExtensions.erase(extension.extensionName);
-    }
+  return stats;
+}
+
+void Context::setMemoryCallback(double threshold, MemoryCallback callback) {
+  mMemoryThreshold = threshold;
+  mMemoryCallback  = std::move(callback);
+  mHeapsOverThreshold.fill(false);
+}
+
+void Context::startTrace() {
+  delete mTracer;
+  mTracer = new Tracer(this);
+}
+
+void Context::stopTrace(std::ostream &stream) {
+  if (!mTracer) throw InvalidUse("stopTrace() called without startTrace()");
+  mTracer->write(stream);
+
+  delete mTracer;
+  mTracer = nullptr;
+}
+
+void Context::beginQuery(purrr::Query *query) {
+  if (query->api() != Api::Vulkan) throw InvalidUse("Uncompatible query object");
+  Query *vkQuery = reinterpret_cast<Query *>(query);
+  // Query slots are rotated by frames, batches are not part of one
+  if (mFrameCommandBuffer != VK_NULL_HANDLE) throw InvalidUse("Queries cannot be used inside batches");
+
+  vkQuery->begin(mCommandBuffer, mFrameIndex);
+  if (mRecording) mRecordQueries.push_back(vkQuery);
+  ++mOpenQueries;
+}
+
+void Context::endQuery(purrr::Query *query) {
+  if (query->api() != Api::Vulkan) throw InvalidUse("Uncompatible query object");
+  Query *vkQuery = reinterpret_cast<Query *>(query);
+  if (vkQuery->isActive() &&
+      mRecording != (std::find(mRecordQueries.begin(), mRecordQueries.end(), vkQuery) != mRecordQueries.end()))
+    throw InvalidUse("Queries have to end inside the record() they began in");
+
+  vkQuery->end(mCommandBuffer);
+  if (!mRecording) vkQuery->copyResults(mCommandBuffer);
+  --mOpenQueries;
+}
+
+void Context::beginConditional(purrr::Query *query) {
+  if (query->api() != Api::Vulkan) throw InvalidUse("Uncompatible query object");
+  if (query->getType() != QueryType::Occlusion) throw InvalidUse("Conditional rendering requires an occlusion query");
+  if (mConditional) throw InvalidUse("Conditional rendering cannot nest");
+  mConditional       = true;
+  mRecordConditional = mRecording;
+
+  VkBuffer     buffer = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  if (!mConditionalRendering || !reinterpret_cast<Query *>(query)->getPredicate(buffer, offset)) return;
+
+  VkConditionalRenderingBeginInfoEXT beginInfo{};
+  beginInfo.sType  = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT;
+  beginInfo.pNext  = VK_NULL_HANDLE;
+  beginInfo.buffer = buffer;
+  beginInfo.offset = offset;
+  beginInfo.flags  = 0;
+
+  mCmdBeginConditionalRendering(mCommandBuffer, &beginInfo);
+  mConditionalActive = true;
+}
+
+void Context::endConditional() {
+  if (!mConditional) throw InvalidUse("endConditional() called without beginConditional()");
+  if (mRecordConditional != mRecording)
+    throw InvalidUse("Conditional rendering has to end inside the record() it began in");
+  mConditional = false;
+
+  if (mConditionalActive) mCmdEndConditionalRendering(mCommandBuffer);
+  mConditionalActive = false;
+}
+
+void Context::forgetPresents(VkSwapchainKHR swapchain) {
+  mLastPresents.erase(
+      std::remove_if(
+          mLastPresents.begin(),
+          mLastPresents.end(),
+          [swapchain](const std::pair<VkSwapchainKHR, uint64_t> &present) { return present.first == swapchain; }),
+      mLastPresents.end());
+}
+
+void Context::createInstance(const ContextInfo &info) {
+  std::vector<const char *> layers{};
+  std::vector<const char *> extensions{};
+
+  appendRequiredVulkanExtensions(extensions);
 
-    if (!requiredExtensions.empty()) throw NotPresent("extensions", requiredExtensions);
+  if (info.debug) {
+    layers.push_back("VK_LAYER_KHRONOS_validation");
+    extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
 
   VkApplicationInfo applicationInfo{};
@@ -455,6 +918,10 @@ void Context::createInstance(const ContextInfo &info) {
   applicationInfo.pEngineName        = info.engineName;
   applicationInfo.engineVersion      = info.engineVersion;
   applicationInfo.apiVersion         = info.apiVersion;
+  // Dynamic rendering, the present wait feature query, memory budgets and device UUIDs depend on functionality
+  // promoted to 1.1
+  bool needs11 = info.dynamicRendering || info.presentWait || info.memoryBudget || info.device.uuid != DeviceUuid{};
+  if (needs11 && info.apiVersion < Version(1, 1)) applicationInfo.apiVersion = Version(1, 1);
 
   VkInstanceCreateInfo createInfo{};
   createInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -466,56 +933,199 @@ void Context::createInstance(const ContextInfo &info) {
   createInfo.enabledExtensionCount   = static_cast<uint32_t>(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
-  expectResult("Instance creation", vkCreateInstance(&createInfo, VK_NULL_HANDLE, &mInstance));
+  // Layers and extensions are only enumerated to tell which ones are missing, that costs a lot on every startup
+  VkResult result = vkCreateInstance(&createInfo, VK_NULL_HANDLE, &mInstance);
+  if (result == VK_ERROR_LAYER_NOT_PRESENT || result == VK_ERROR_EXTENSION_NOT_PRESENT) {
+    { // Check if every required layer is present
+      uint32_t count = 0;
+      expectResult("Instance layer enumeration", vkEnumerateInstanceLayerProperties(&count, VK_NULL_HANDLE));
+
+      std::vector<VkLayerProperties> availableLayers(count);
+      expectResult("Instance layer enumeration", vkEnumerateInstanceLayerProperties(&count, availableLayers.data()));
+
+      std::unordered_set<std::string_view> requiredLayers(layers.begin(), layers.end());
+      for (const VkLayerProperties &layer : availableLayers) {
+        requiredLayers.erase(layer.layerName);
+      }
+
+      if (!requiredLayers.empty()) throw NotPresent("layers", requiredLayers);
+    }
+
+    { // Check if every required extension is present
+      uint32_t count = 0;
+      expectResult(
+          "Instance extension enumeration",
+          vkEnumerateInstanceExtensionProperties(VK_NULL_HANDLE, &count, VK_NULL_HANDLE));
+
+      std::vector<VkExtensionProperties> availableExtensions(count);
+      expectResult(
+          "Instance extension enumeration",
+          vkEnumerateInstanceExtensionProperties(VK_NULL_HANDLE, &count, availableExtensions.data()));
+
+      std::unordered_set<std::string_view> requiredExtensions(extensions.begin(), extensions.end());
+      for (const VkExtensionProperties &extension : availableExtensions) {
+        requiredExtensions.erase(extension.extensionName);
+      }
+
+      if (!requiredExtensions.empty()) throw NotPresent("extensions", requiredExtensions);
+    }
+  }
+  expectResult("Instance creation", result);
+  mApiVersion = applicationInfo.apiVersion;
+}
+
+static VKAPI_ATTR VkBool32 VKAPI_CALL debugMessage(
+    VkDebugUtilsMessageSeverityFlagBitsEXT,
+    VkDebugUtilsMessageTypeFlagsEXT,
+    const VkDebugUtilsMessengerCallbackDataEXT *data,
+    void                                       *userData) {
+  const DebugCallback &callback = *reinterpret_cast<const DebugCallback *>(userData);
+  if (callback)
+    callback(data->pMessage);
+  else
+    std::cerr << data->pMessage << std::endl;
+
+  return VK_FALSE;
 }
 
-void Context::chooseDevice(const std::vector<const char *> &extensions) {
+void Context::createDebugMessenger() {
+  if (!mDebug) return;
+
+  auto createDebugUtilsMessenger = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+      vkGetInstanceProcAddr(mInstance, "vkCreateDebugUtilsMessengerEXT"));
+
+  VkDebugUtilsMessengerCreateInfoEXT createInfo{};
+  createInfo.sType           = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+  createInfo.pNext           = VK_NULL_HANDLE;
+  createInfo.flags           = 0;
+  createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+                               VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+  createInfo.messageType     = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                               VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                               VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+  createInfo.pfnUserCallback = debugMessage;
+  createInfo.pUserData       = &mDebugCallback;
+
+  expectResult(
+      "Debug messenger creation", createDebugUtilsMessenger(mInstance, &createInfo, VK_NULL_HANDLE, &mDebugMessenger));
+}
+
+static bool matchesSelection(const DeviceDescription &description, const DeviceSelection &selection) {
+  if (selection.name && description.name.find(selection.name) == std::string::npos) return false;
+
+  const DeviceFeatures &supported = description.features;
+  const DeviceFeatures &required  = selection.required;
+  return (supported.imageCubeArray || !required.imageCubeArray) &&
+         (supported.textureCompressionBC || !required.textureCompressionBC) &&
+         (supported.textureCompressionETC2 || !required.textureCompressionETC2) &&
+         (supported.textureCompressionASTC || !required.textureCompressionASTC) &&
+         (supported.occlusionQueryPrecise || !required.occlusionQueryPrecise) &&
+         (supported.pipelineStatistics || !required.pipelineStatistics) &&
+         (supported.timestamps || !required.timestamps);
+}
+
+void Context::chooseDevice(const std::vector<const char *> &extensions, const DeviceSelection &selection) {
   uint32_t count = 0;
   expectResult("Physical device enumeration", vkEnumeratePhysicalDevices(mInstance, &count, VK_NULL_HANDLE));
 
   std::vector<VkPhysicalDevice> devices(count);
   expectResult("Physical device enumeration", vkEnumeratePhysicalDevices(mInstance, &count, devices.data()));
 
+  // The requested device is taken as long as it is still suitable, no other device is looked at then
+  if (selection.uuid != DeviceUuid{}) {
+    // Tells callers spreading work over devices whether the device is gone or lacks something
+    const char *unsuitable = "The selected device is missing";
+    for (VkPhysicalDevice device : devices) {
+      if (queryDeviceUuid(device, mApiVersion) != selection.uuid) continue;
+
+      DeviceDescription description      = describeDevice(device, mApiVersion);
+      uint32_t          queueFamilyIndex = findQueueFamily(device);
+      if (!matchesSelection(description, selection)) {
+        unsuitable = "The selected device does not match the name or required features of the device selection";
+        break;
+      }
+      if (queueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) {
+        unsuitable = "The selected device has no graphics queue";
+        break;
+      }
+      if (!deviceExtensionsPresent(device, extensions)) {
+        unsuitable = "The selected device does not have every required extension present";
+        break;
+      }
+
+      mPhysicalDevice            = device;
+      mQueueFamilyIndex          = queueFamilyIndex;
+      mDeviceDescription         = description;
+      mStartupStats.cachedDevice = true;
+      return;
+    }
+
+    if (selection.uuidOnly) throw std::runtime_error(unsuitable);
+  }
+
   /*
    0 - every device scored 0
-   1 - no device that scored more than 0, had a graphics queue
-   2 - no suitable device had all required extensions present
+   1 - no device matched the name or required features of the selection
+   2 - no matching device that scored more than 0, had a graphics queue
+   3 - no suitable device had all required extensions present
    */
   uint32_t found = 0;
 
-  uint32_t bestScore = 0;
-  for (VkPhysicalDevice device : devices) {
-    uint32_t score = scorePhysicalDevice(device);
+  uint64_t bestScore = 0;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    DeviceDescription description = describeDevice(devices[i], mApiVersion);
+    if (!matchesSelection(description, selection)) {
+      if (found < 1) found = 1;
+      continue;
+    }
+
+    uint64_t score = 0;
+    switch (selection.preference) {
+    case DevicePreference::Type: score = scorePhysicalDevice(devices[i]); break;
+    case DevicePreference::MostMemory: score = description.localMemory; break;
+    case DevicePreference::First: score = devices.size() - i; break;
+    }
     if (score <= bestScore) continue;
 
-    uint32_t queueFamilyIndex = findQueueFamily(device);
+    uint32_t queueFamilyIndex = findQueueFamily(devices[i]);
     if (queueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) {
-      if (found < 1) found = 1;
+      if (found < 2) found = 2;
       continue;
     }
 
-    if (!deviceExtensionsPresent(device, extensions)) {
-      found = 2;
+    if (!deviceExtensionsPresent(devices[i], extensions)) {
+      found = 3;
       continue;
     }
 
-    bestScore         = score;
-    mPhysicalDevice   = device;
-    mQueueFamilyIndex = queueFamilyIndex;
+    bestScore          = score;
+    mPhysicalDevice    = devices[i];
+    mQueueFamilyIndex  = queueFamilyIndex;
+    mDeviceDescription = description;
   }
 
   if (!mPhysicalDevice) {
     switch (found) {
     case 0:
-    case 1: throw std::runtime_error("No suitable devices found");
-    case 2: throw std::runtime_error("No suitable device had every required extension present");
+    case 2: throw std::runtime_error("No suitable devices found");
+    case 1: throw std::runtime_error("No device matched the device selection");
+    case 3: throw std::runtime_error("No suitable device had every required extension present");
     default: throw std::runtime_error("Something went wrong...");
     }
   }
 }
 
 void Context::createDevice(const std::vector<const char *> &extensions) {
+  VkPhysicalDeviceFeatures supportedFeatures{};
+  vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures features{};
+  features.imageCubeArray             = supportedFeatures.imageCubeArray;
+  features.textureCompressionBC       = supportedFeatures.textureCompressionBC;
+  features.textureCompressionETC2     = supportedFeatures.textureCompressionETC2;
+  features.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+  features.occlusionQueryPrecise      = supportedFeatures.occlusionQueryPrecise;
+  features.pipelineStatisticsQuery    = supportedFeatures.pipelineStatisticsQuery;
 
   float                   priorities = 0.0f;
   VkDeviceQueueCreateInfo queueCreateInfo{};
@@ -538,10 +1148,95 @@ void Context::createDevice(const std::vector<const char *> &extensions) {
   createInfo.ppEnabledExtensionNames = extensions.data();
   createInfo.pEnabledFeatures        = &features;
 
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+  dynamicRenderingFeatures.sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  dynamicRenderingFeatures.pNext            = VK_NULL_HANDLE;
+  dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+  if (mDynamicRendering) createInfo.pNext = &dynamicRenderingFeatures;
+
+  VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+  presentIdFeatures.sType     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  presentIdFeatures.pNext     = const_cast<void *>(createInfo.pNext);
+  presentIdFeatures.presentId = VK_TRUE;
+
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+  presentWaitFeatures.sType       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  presentWaitFeatures.pNext       = &presentIdFeatures;
+  presentWaitFeatures.presentWait = VK_TRUE;
+  if (mPresentWait) createInfo.pNext = &presentWaitFeatures;
+
+  VkPhysicalDeviceConditionalRenderingFeaturesEXT conditional{};
+  conditional.sType                         = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT;
+  conditional.pNext                         = const_cast<void *>(createInfo.pNext);
+  conditional.conditionalRendering          = VK_TRUE;
+  conditional.inheritedConditionalRendering = VK_FALSE;
+  if (mConditionalRendering) createInfo.pNext = &conditional;
+
   expectResult("Device creation", vkCreateDevice(mPhysicalDevice, &createInfo, VK_NULL_HANDLE, &mDevice));
+  mEnabledFeatures = features;
 }
 
-void Context::getQueue() {
+void Context::loadFunctions() {
+  if (mDynamicRendering) {
+    mCmdBeginRendering =
+        reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(mDevice, "vkCmdBeginRenderingKHR"));
+    mCmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(mDevice, "vkCmdEndRenderingKHR"));
+  }
+
+  if (mPresentWait)
+    mWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(mDevice, "vkWaitForPresentKHR"));
+
+  if (mConditionalRendering) {
+    mCmdBeginConditionalRendering = reinterpret_cast<PFN_vkCmdBeginConditionalRenderingEXT>(
+        vkGetDeviceProcAddr(mDevice, "vkCmdBeginConditionalRenderingEXT"));
+    mCmdEndConditionalRendering = reinterpret_cast<PFN_vkCmdEndConditionalRenderingEXT>(
+        vkGetDeviceProcAddr(mDevice, "vkCmdEndConditionalRenderingEXT"));
+  }
+
+  if (mDebug) {
+    mSetDebugUtilsObjectName = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(
+        vkGetInstanceProcAddr(mInstance, "vkSetDebugUtilsObjectNameEXT"));
+    mCmdBeginDebugUtilsLabel = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(
+        vkGetInstanceProcAddr(mInstance, "vkCmdBeginDebugUtilsLabelEXT"));
+    mCmdEndDebugUtilsLabel = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(
+        vkGetInstanceProcAddr(mInstance, "vkCmdEndDebugUtilsLabelEXT"));
+  }
+}
+
+bool Context::presentWaitSupported() const {
+  VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+  presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  presentIdFeatures.pNext = VK_NULL_HANDLE;
+
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+  presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  presentWaitFeatures.pNext = &presentIdFeatures;
+
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &presentWaitFeatures;
+  vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &features);
+
+  return presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+}
+
+void Context::beginRendering(const VkRect2D &renderArea, const std::vector<VkRenderingAttachmentInfoKHR> &attachments) {
+  VkRenderingInfoKHR renderingInfo{};
+  renderingInfo.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+  renderingInfo.pNext                = VK_NULL_HANDLE;
+  renderingInfo.flags                = 0;
+  renderingInfo.renderArea           = renderArea;
+  renderingInfo.layerCount           = 1;
+  renderingInfo.viewMask             = 0;
+  renderingInfo.colorAttachmentCount = static_cast<uint32_t>(attachments.size());
+  renderingInfo.pColorAttachments    = attachments.data();
+  renderingInfo.pDepthAttachment     = VK_NULL_HANDLE;
+  renderingInfo.pStencilAttachment   = VK_NULL_HANDLE;
+
+  mCmdBeginRendering(mCommandBuffer, &renderingInfo);
+}
+
+void Context::retrieveQueue() {
   vkGetDeviceQueue(mDevice, mQueueFamilyIndex, 0, &mQueue);
 }
 
@@ -635,12 +1330,66 @@ void Context::createDescriptorSetLayouts() {
         "Descriptor set layout creation",
         vkCreateDescriptorSetLayout(mDevice, &createInfo, VK_NULL_HANDLE, &mStorageDescriptorSetLayout));
   }
+
+  { // Input attachment
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding            = 0;
+    binding.descriptorType     = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    binding.descriptorCount    = 1;
+    binding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
+    binding.pImmutableSamplers = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayoutCreateInfo createInfo{};
+    createInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.pNext        = VK_NULL_HANDLE;
+    createInfo.flags        = 0;
+    createInfo.bindingCount = 1;
+    createInfo.pBindings    = &binding;
+
+    expectResult(
+        "Descriptor set layout creation",
+        vkCreateDescriptorSetLayout(mDevice, &createInfo, VK_NULL_HANDLE, &mInputDescriptorSetLayout));
+  }
+}
+
+void Context::createDescriptors() {
+  // The pool is created last, it marks the whole set as present
+  if (mDescriptorPool != VK_NULL_HANDLE) return;
+
+  createDescriptorSetLayouts();
+  createDescriptorPool();
+}
+
+VkDescriptorSetLayout Context::getTextureDescriptorSetLayout() {
+  createDescriptors();
+  return mTextureDescriptorSetLayout;
+}
+
+VkDescriptorSetLayout Context::getUniformDescriptorSetLayout() {
+  createDescriptors();
+  return mUniformDescriptorSetLayout;
+}
+
+VkDescriptorSetLayout Context::getStorageDescriptorSetLayout() {
+  createDescriptors();
+  return mStorageDescriptorSetLayout;
+}
+
+VkDescriptorSetLayout Context::getInputDescriptorSetLayout() {
+  createDescriptors();
+  return mInputDescriptorSetLayout;
+}
+
+VkDescriptorPool Context::getDescriptorPool() {
+  createDescriptors();
+  return mDescriptorPool;
 }
 
 void Context::createDescriptorPool() {
-  std::array<VkDescriptorPoolSize, 3> poolSizes = { { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1024 },
+  std::array<VkDescriptorPoolSize, 4> poolSizes = { { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1024 },
                                                       { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1024 },
-                                                      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1024 } } };
+                                                      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1024 },
+                                                      { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1024 } } };
 
   VkDescriptorPoolCreateInfo createInfo{};
   createInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -685,22 +1434,133 @@ uint32_t Context::scorePhysicalDevice(VkPhysicalDevice device) {
 }
 
 bool Context::deviceExtensionsPresent(VkPhysicalDevice device, const std::vector<const char *> extensions) {
-  uint32_t count = 0;
-  expectResult(
-      "Device extension enumeration",
-      vkEnumerateDeviceExtensionProperties(device, VK_NULL_HANDLE, &count, VK_NULL_HANDLE));
+  auto [available, inserted] = mDeviceExtensions.try_emplace(device);
+  if (inserted) {
+    uint32_t count = 0;
+    expectResult(
+        "Device extension enumeration",
+        vkEnumerateDeviceExtensionProperties(device, VK_NULL_HANDLE, &count, VK_NULL_HANDLE));
 
-  std::vector<VkExtensionProperties> availableExtensions(count);
-  expectResult(
-      "Device extension enumeration",
-      vkEnumerateDeviceExtensionProperties(device, VK_NULL_HANDLE, &count, availableExtensions.data()));
+    std::vector<VkExtensionProperties> availableExtensions(count);
+    expectResult(
+        "Device extension enumeration",
+        vkEnumerateDeviceExtensionProperties(device, VK_NULL_HANDLE, &count, availableExtensions.data()));
+
+    for (const VkExtensionProperties &extension : availableExtensions) {
+      available->second.insert(extension.extensionName);
+    }
+  }
+
+  for (const char *extension : extensions) {
+    if (available->second.count(extension) == 0) return false;
+  }
+
+  return true;
+}
 
-  std::unordered_set<std::string_view> requiredExtensions(extensions.begin(), extensions.end());
-  for (const VkExtensionProperties &extension : availableExtensions) {
-    requiredExtensions.erase(extension.extensionName);
+DeviceUuid Context::queryDeviceUuid(VkPhysicalDevice device, uint32_t instanceVersion) {
+  DeviceUuid uuid{};
+  if (instanceVersion < Version(1, 1)) return uuid;
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(device, &properties);
+  if (properties.apiVersion < Version(1, 1)) return uuid;
+
+  VkPhysicalDeviceIDProperties idProperties{};
+  idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+  idProperties.pNext = VK_NULL_HANDLE;
+
+  VkPhysicalDeviceProperties2 properties2{};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &idProperties;
+
+  vkGetPhysicalDeviceProperties2(device, &properties2);
+  static_assert(sizeof(uuid) == VK_UUID_SIZE);
+  std::copy(std::begin(idProperties.deviceUUID), std::end(idProperties.deviceUUID), uuid.begin());
+  return uuid;
+}
+
+DeviceDescription Context::describeDevice(VkPhysicalDevice device, uint32_t instanceVersion) {
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(device, &properties);
+
+  VkPhysicalDeviceFeatures features{};
+  vkGetPhysicalDeviceFeatures(device, &features);
+
+  VkPhysicalDeviceMemoryProperties memoryProperties{};
+  vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+  DeviceDescription description{};
+  description.name = properties.deviceName;
+  description.uuid = queryDeviceUuid(device, instanceVersion);
+
+  switch (properties.deviceType) {
+  case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: description.type = DeviceType::Integrated; break;
+  case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: description.type = DeviceType::Discrete; break;
+  case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: description.type = DeviceType::Virtual; break;
+  case VK_PHYSICAL_DEVICE_TYPE_CPU: description.type = DeviceType::Cpu; break;
+  default: description.type = DeviceType::Other; break;
   }
 
-  return requiredExtensions.empty();
+  description.localMemory = 0;
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+      description.localMemory += memoryProperties.memoryHeaps[i].size;
+
+  uint32_t queueFamilyIndex = findQueueFamily(device);
+  bool     timestamps       = queueFamilyIndex != VK_QUEUE_FAMILY_IGNORED &&
+                              GpuProfiler::timestampBits(device, queueFamilyIndex) > 0;
+
+  // Matches what createDevice() enables
+  description.features.imageCubeArray         = features.imageCubeArray;
+  description.features.textureCompressionBC   = features.textureCompressionBC;
+  description.features.textureCompressionETC2 = features.textureCompressionETC2;
+  description.features.textureCompressionASTC = features.textureCompressionASTC_LDR;
+  description.features.occlusionQueryPrecise  = features.occlusionQueryPrecise;
+  description.features.pipelineStatistics     = features.pipelineStatisticsQuery;
+  description.features.timestamps             = timestamps;
+
+  return description;
+}
+
+std::vector<DeviceDescription> Context::enumerateDevices() {
+  // Device UUIDs need 1.1, nothing else is enabled
+  VkApplicationInfo applicationInfo{};
+  applicationInfo.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  applicationInfo.pNext              = VK_NULL_HANDLE;
+  applicationInfo.pApplicationName   = nullptr;
+  applicationInfo.applicationVersion = 0;
+  applicationInfo.pEngineName        = nullptr;
+  applicationInfo.engineVersion      = 0;
+  applicationInfo.apiVersion         = Version(1, 1);
+
+  VkInstanceCreateInfo createInfo{};
+  createInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  createInfo.pNext                   = VK_NULL_HANDLE;
+  createInfo.flags                   = 0;
+  createInfo.pApplicationInfo        = &applicationInfo;
+  createInfo.enabledLayerCount       = 0;
+  createInfo.ppEnabledLayerNames     = VK_NULL_HANDLE;
+  createInfo.enabledExtensionCount   = 0;
+  createInfo.ppEnabledExtensionNames = VK_NULL_HANDLE;
+
+  VkInstance instance = VK_NULL_HANDLE;
+  expectResult("Instance creation", vkCreateInstance(&createInfo, VK_NULL_HANDLE, &instance));
+
+  // The instance has to be destroyed before a failed enumeration throws
+  uint32_t                      count  = 0;
+  VkResult                      result = vkEnumeratePhysicalDevices(instance, &count, VK_NULL_HANDLE);
+  std::vector<VkPhysicalDevice> devices(count);
+  if (result == VK_SUCCESS) result = vkEnumeratePhysicalDevices(instance, &count, devices.data());
+
+  std::vector<DeviceDescription> descriptions{};
+  if (result == VK_SUCCESS)
+    for (VkPhysicalDevice device : devices) descriptions.push_back(describeDevice(device, applicationInfo.apiVersion));
+
+  vkDestroyInstance(instance, VK_NULL_HANDLE);
+  expectResult("Physical device enumeration", result);
+
+  return descriptions;
 }
 
 uint32_t Context::findQueueFamily(VkPhysicalDevice device) {
@@ -730,6 +1590,160 @@ uint32_t Context::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prop
   throw std::runtime_error("Failed to find suitable memory type");
 }
 
+uint32_t Context::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags preferred, VkMemoryPropertyFlags fallback) {
+  VkPhysicalDeviceMemoryProperties memoryProperties{};
+  vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &memoryProperties);
+
+  for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & preferred) == preferred) {
+      return i;
+    }
+  }
+
+  return findMemoryType(typeFilter, fallback);
+}
+
+VkDeviceMemory Context::allocateMemory(const VkMemoryAllocateInfo &allocateInfo) {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  expectResult("Memory allocation", vkAllocateMemory(mDevice, &allocateInfo, VK_NULL_HANDLE, &memory));
+
+  uint32_t heap         = mMemoryProperties.memoryTypes[allocateInfo.memoryTypeIndex].heapIndex;
+  mAllocations[memory]  = { heap, allocateInfo.allocationSize };
+  mHeapAllocated[heap] += allocateInfo.allocationSize;
+
+  if (mMemoryCallback) checkMemoryThreshold();
+  return memory;
+}
+
+void Context::freeMemory(VkDeviceMemory memory) {
+  if (memory == VK_NULL_HANDLE) return;
+
+  auto it = mAllocations.find(memory);
+  if (it != mAllocations.end()) {
+    mHeapAllocated[it->second.first] -= it->second.second;
+    mAllocations.erase(it);
+  }
+
+  vkFreeMemory(mDevice, memory, VK_NULL_HANDLE);
+}
+
+void Context::checkMemoryThreshold() {
+  MemoryStats stats = getMemoryStats();
+  for (uint32_t i = 0; i < stats.heaps.size(); ++i) {
+    const MemoryHeapStats &heap = stats.heaps[i];
+
+    bool over = static_cast<double>(heap.usage) > mMemoryThreshold * static_cast<double>(heap.budget);
+    if (over && !mHeapsOverThreshold[i]) {
+      mHeapsOverThreshold[i] = true;
+      mMemoryCallback(stats, i); // Marked first, the callback may allocate
+    } else if (!over) {
+      mHeapsOverThreshold[i] = false;
+    }
+  }
+}
+
+ReadbackRing *Context::getReadbackRing() {
+  if (!mReadbackRing) mReadbackRing = new ReadbackRing(this, 4 * 1024 * 1024);
+  return mReadbackRing;
+}
+
+void Context::beginBatch(VkCommandBuffer commandBuffer) {
+  if (mRecording) throw InvalidUse("Cannot begin a batch while recording");
+  if (mFrameCommandBuffer != VK_NULL_HANDLE) throw InvalidUse("Batches cannot nest");
+
+  expectResult("Command buffer reset", vkResetCommandBuffer(commandBuffer, 0));
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.pNext            = VK_NULL_HANDLE;
+  beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = VK_NULL_HANDLE;
+
+  expectResult("Command buffer begin", vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+  // Timestamps of the profiler belong to the frame command buffer
+  mFrameCommandBuffer = mCommandBuffer;
+  mFrameProfiler      = mProfiler;
+  mCommandBuffer      = commandBuffer;
+  mProfiler           = nullptr;
+}
+
+void Context::submitBatch(VkFence fence) {
+  if (mFrameCommandBuffer == VK_NULL_HANDLE) throw InvalidUse("submitBatch() called before beginBatch()");
+  if (mRecording) throw InvalidUse("Cannot submit while recording");
+
+  VkCommandBuffer commandBuffer = mCommandBuffer;
+  mCommandBuffer                = mFrameCommandBuffer;
+  mProfiler                     = mFrameProfiler;
+  mFrameCommandBuffer           = VK_NULL_HANDLE;
+  mFrameProfiler                = nullptr;
+
+  expectResult("Command buffer end", vkEndCommandBuffer(commandBuffer));
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.pNext                = VK_NULL_HANDLE;
+  submitInfo.waitSemaphoreCount   = 0;
+  submitInfo.pWaitSemaphores      = VK_NULL_HANDLE;
+  submitInfo.pWaitDstStageMask    = VK_NULL_HANDLE;
+  submitInfo.commandBufferCount   = 1;
+  submitInfo.pCommandBuffers      = &commandBuffer;
+  submitInfo.signalSemaphoreCount = 0;
+  submitInfo.pSignalSemaphores    = VK_NULL_HANDLE;
+
+  expectResult("Queue submition", vkQueueSubmit(mQueue, 1, &submitInfo, fence));
+  ++mStats.submits;
+}
+
+void Context::abortBatch() {
+  if (mFrameCommandBuffer == VK_NULL_HANDLE) return;
+
+  VkCommandBuffer commandBuffer = mCommandBuffer;
+  mCommandBuffer                = mFrameCommandBuffer;
+  mProfiler                     = mFrameProfiler;
+  mFrameCommandBuffer           = VK_NULL_HANDLE;
+  mFrameProfiler                = nullptr;
+
+  // Whatever the batch left open is dropped along with its commands
+  mRecording         = false;
+  mRenderTarget      = nullptr;
+  mConditional       = false;
+  mRecordConditional = false;
+  mConditionalActive = false;
+  mRecordQueries.clear();
+
+  expectResult("Command buffer reset", vkResetCommandBuffer(commandBuffer, 0));
+}
+
+void Context::setObjectName(VkObjectType type, uint64_t handle, const char *name) {
+  if (!mSetDebugUtilsObjectName || !name) return;
+
+  VkDebugUtilsObjectNameInfoEXT nameInfo{};
+  nameInfo.sType        = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+  nameInfo.pNext        = VK_NULL_HANDLE;
+  nameInfo.objectType   = type;
+  nameInfo.objectHandle = handle;
+  nameInfo.pObjectName  = name;
+
+  expectResult("Object naming", mSetDebugUtilsObjectName(mDevice, &nameInfo));
+}
+
+void Context::beginLabel(const char *name) {
+  if (!mCmdBeginDebugUtilsLabel) return;
+
+  // Unnamed labels are still pushed, endLabel() always pops one
+  VkDebugUtilsLabelEXT label{};
+  label.sType      = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+  label.pNext      = VK_NULL_HANDLE;
+  label.pLabelName = name ? name : "Scope";
+
+  mCmdBeginDebugUtilsLabel(mCommandBuffer, &label);
+}
+
+void Context::endLabel() {
+  if (mCmdEndDebugUtilsLabel) mCmdEndDebugUtilsLabel(mCommandBuffer);
+}
+
 VkCommandBuffer Context::beginSingleTimeCommands() {
   VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
 
@@ -769,6 +1783,7 @@ void Context::submitSingleTimeCommands(VkCommandBuffer commandBuffer) {
 
   vkQueueSubmit(mQueue, 1, &submitInfo, VK_NULL_HANDLE);
   vkQueueWaitIdle(mQueue);
+  ++mStats.submits;
 
   vkFreeCommandBuffers(mDevice, mCommandPool, 1, &commandBuffer);
 }
@@ -139,6 +139,60 @@ VkFormat vkFormat(Format format) {
   case Format::D16UnormS8Uint: return VK_FORMAT_D16_UNORM_S8_UINT;
   case Format::D24UnormS8Uint: return VK_FORMAT_D24_UNORM_S8_UINT;
   case Format::D32SfloatS8Uint: return VK_FORMAT_D32_SFLOAT_S8_UINT;
+  case Format::BC1RGBUnormBlock: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+  case Format::BC1RGBSrgbBlock: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+  case Format::BC1RGBAUnormBlock: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+  case Format::BC1RGBASrgbBlock: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+  case Format::BC2UnormBlock: return VK_FORMAT_BC2_UNORM_BLOCK;
+  case Format::BC2SrgbBlock: return VK_FORMAT_BC2_SRGB_BLOCK;
+  case Format::BC3UnormBlock: return VK_FORMAT_BC3_UNORM_BLOCK;
+  case Format::BC3SrgbBlock: return VK_FORMAT_BC3_SRGB_BLOCK;
+  case Format::BC4UnormBlock: return VK_FORMAT_BC4_UNORM_BLOCK;
+  case Format::BC4SnormBlock: return VK_FORMAT_BC4_SNORM_BLOCK;
+  case Format::BC5UnormBlock: return VK_FORMAT_BC5_UNORM_BLOCK;
+  case Format::BC5SnormBlock: return VK_FORMAT_BC5_SNORM_BLOCK;
+  case Format::BC6HUfloatBlock: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+  case Format::BC6HSfloatBlock: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+  case Format::BC7UnormBlock: return VK_FORMAT_BC7_UNORM_BLOCK;
+  case Format::BC7SrgbBlock: return VK_FORMAT_BC7_SRGB_BLOCK;
+  case Format::ETC2RGB8UnormBlock: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+  case Format::ETC2RGB8SrgbBlock: return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
+  case Format::ETC2RGB8A1UnormBlock: return VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK;
+  case Format::ETC2RGB8A1SrgbBlock: return VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK;
+  case Format::ETC2RGBA8UnormBlock: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+  case Format::ETC2RGBA8SrgbBlock: return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+  case Format::EACR11UnormBlock: return VK_FORMAT_EAC_R11_UNORM_BLOCK;
+  case Format::EACR11SnormBlock: return VK_FORMAT_EAC_R11_SNORM_BLOCK;
+  case Format::EACRG11UnormBlock: return VK_FORMAT_EAC_R11G11_UNORM_BLOCK;
+  case Format::EACRG11SnormBlock: return VK_FORMAT_EAC_R11G11_SNORM_BLOCK;
+  case Format::ASTC4x4UnormBlock: return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+  case Format::ASTC4x4SrgbBlock: return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+  case Format::ASTC5x4UnormBlock: return VK_FORMAT_ASTC_5x4_UNORM_BLOCK;
+  case Format::ASTC5x4SrgbBlock: return VK_FORMAT_ASTC_5x4_SRGB_BLOCK;
+  case Format::ASTC5x5UnormBlock: return VK_FORMAT_ASTC_5x5_UNORM_BLOCK;
+  case Format::ASTC5x5SrgbBlock: return VK_FORMAT_ASTC_5x5_SRGB_BLOCK;
+  case Format::ASTC6x5UnormBlock: return VK_FORMAT_ASTC_6x5_UNORM_BLOCK;
+  case Format::ASTC6x5SrgbBlock: return VK_FORMAT_ASTC_6x5_SRGB_BLOCK;
+  case Format::ASTC6x6UnormBlock: return VK_FORMAT_ASTC_6x6_UNORM_BLOCK;
+  case Format::ASTC6x6SrgbBlock: return VK_FORMAT_ASTC_6x6_SRGB_BLOCK;
+  case Format::ASTC8x5UnormBlock: return VK_FORMAT_ASTC_8x5_UNORM_BLOCK;
+  case Format::ASTC8x5SrgbBlock: return VK_FORMAT_ASTC_8x5_SRGB_BLOCK;
+  case Format::ASTC8x6UnormBlock: return VK_FORMAT_ASTC_8x6_UNORM_BLOCK;
+  case Format::ASTC8x6SrgbBlock: return VK_FORMAT_ASTC_8x6_SRGB_BLOCK;
+  case Format::ASTC8x8UnormBlock: return VK_FORMAT_ASTC_8x8_UNORM_BLOCK;
+  case Format::ASTC8x8SrgbBlock: return VK_FORMAT_ASTC_8x8_SRGB_BLOCK;
+  case Format::ASTC10x5UnormBlock: return VK_FORMAT_ASTC_10x5_UNORM_BLOCK;
+  case Format::ASTC10x5SrgbBlock: return VK_FORMAT_ASTC_10x5_SRGB_BLOCK;
+  case Format::ASTC10x6UnormBlock: return VK_FORMAT_ASTC_10x6_UNORM_BLOCK;
+  case Format::ASTC10x6SrgbBlock: return VK_FORMAT_ASTC_10x6_SRGB_BLOCK;
+  case Format::ASTC10x8UnormBlock: return VK_FORMAT_ASTC_10x8_UNORM_BLOCK;
+  case Format::ASTC10x8SrgbBlock: return VK_FORMAT_ASTC_10x8_SRGB_BLOCK;
+  case Format::ASTC10x10UnormBlock: return VK_FORMAT_ASTC_10x10_UNORM_BLOCK;
+  case Format::ASTC10x10SrgbBlock: return VK_FORMAT_ASTC_10x10_SRGB_BLOCK;
+  case Format::ASTC12x10UnormBlock: return VK_FORMAT_ASTC_12x10_UNORM_BLOCK;
+  case Format::ASTC12x10SrgbBlock: return VK_FORMAT_ASTC_12x10_SRGB_BLOCK;
+  case Format::ASTC12x12UnormBlock: return VK_FORMAT_ASTC_12x12_UNORM_BLOCK;
+  case Format::ASTC12x12SrgbBlock: return VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
   }
 
   throw Unreachable();
@@ -277,6 +331,60 @@ Format format(VkFormat vkFormat) {
   case VK_FORMAT_D16_UNORM_S8_UINT: return Format::D16UnormS8Uint;
   case VK_FORMAT_D24_UNORM_S8_UINT: return Format::D24UnormS8Uint;
   case VK_FORMAT_D32_SFLOAT_S8_UINT: return Format::D32SfloatS8Uint;
+  case VK_FORMAT_BC1_RGB_UNORM_BLOCK: return Format::BC1RGBUnormBlock;
+  case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return Format::BC1RGBSrgbBlock;
+  case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return Format::BC1RGBAUnormBlock;
+  case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return Format::BC1RGBASrgbBlock;
+  case VK_FORMAT_BC2_UNORM_BLOCK: return Format::BC2UnormBlock;
+  case VK_FORMAT_BC2_SRGB_BLOCK: return Format::BC2SrgbBlock;
+  case VK_FORMAT_BC3_UNORM_BLOCK: return Format::BC3UnormBlock;
+  case VK_FORMAT_BC3_SRGB_BLOCK: return Format::BC3SrgbBlock;
+  case VK_FORMAT_BC4_UNORM_BLOCK: return Format::BC4UnormBlock;
+  case VK_FORMAT_BC4_SNORM_BLOCK: return Format::BC4SnormBlock;
+  case VK_FORMAT_BC5_UNORM_BLOCK: return Format::BC5UnormBlock;
+  case VK_FORMAT_BC5_SNORM_BLOCK: return Format::BC5SnormBlock;
+  case VK_FORMAT_BC6H_UFLOAT_BLOCK: return Format::BC6HUfloatBlock;
+  case VK_FORMAT_BC6H_SFLOAT_BLOCK: return Format::BC6HSfloatBlock;
+  case VK_FORMAT_BC7_UNORM_BLOCK: return Format::BC7UnormBlock;
+  case VK_FORMAT_BC7_SRGB_BLOCK: return Format::BC7SrgbBlock;
+  case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: return Format::ETC2RGB8UnormBlock;
+  case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK: return Format::ETC2RGB8SrgbBlock;
+  case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: return Format::ETC2RGB8A1UnormBlock;
+  case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK: return Format::ETC2RGB8A1SrgbBlock;
+  case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: return Format::ETC2RGBA8UnormBlock;
+  case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK: return Format::ETC2RGBA8SrgbBlock;
+  case VK_FORMAT_EAC_R11_UNORM_BLOCK: return Format::EACR11UnormBlock;
+  case VK_FORMAT_EAC_R11_SNORM_BLOCK: return Format::EACR11SnormBlock;
+  case VK_FORMAT_EAC_R11G11_UNORM_BLOCK: return Format::EACRG11UnormBlock;
+  case VK_FORMAT_EAC_R11G11_SNORM_BLOCK: return Format::EACRG11SnormBlock;
+  case VK_FORMAT_ASTC_4x4_UNORM_BLOCK: return Format::ASTC4x4UnormBlock;
+  case VK_FORMAT_ASTC_4x4_SRGB_BLOCK: return Format::ASTC4x4SrgbBlock;
+  case VK_FORMAT_ASTC_5x4_UNORM_BLOCK: return Format::ASTC5x4UnormBlock;
+  case VK_FORMAT_ASTC_5x4_SRGB_BLOCK: return Format::ASTC5x4SrgbBlock;
+  case VK_FORMAT_ASTC_5x5_UNORM_BLOCK: return Format::ASTC5x5UnormBlock;
+  case VK_FORMAT_ASTC_5x5_SRGB_BLOCK: return Format::ASTC5x5SrgbBlock;
+  case VK_FORMAT_ASTC_6x5_UNORM_BLOCK: return Format::ASTC6x5UnormBlock;
+  case VK_FORMAT_ASTC_6x5_SRGB_BLOCK: return Format::ASTC6x5SrgbBlock;
+  case VK_FORMAT_ASTC_6x6_UNORM_BLOCK: return Format::ASTC6x6UnormBlock;
+  case VK_FORMAT_ASTC_6x6_SRGB_BLOCK: return Format::ASTC6x6SrgbBlock;
+  case VK_FORMAT_ASTC_8x5_UNORM_BLOCK: return Format::ASTC8x5UnormBlock;
+  case VK_FORMAT_ASTC_8x5_SRGB_BLOCK: return Format::ASTC8x5SrgbBlock;
+  case VK_FORMAT_ASTC_8x6_UNORM_BLOCK: return Format::ASTC8x6UnormBlock;
+  case VK_FORMAT_ASTC_8x6_SRGB_BLOCK: return Format::ASTC8x6SrgbBlock;
+  case VK_FORMAT_ASTC_8x8_UNORM_BLOCK: return Format::ASTC8x8UnormBlock;
+  case VK_FORMAT_ASTC_8x8_SRGB_BLOCK: return Format::ASTC8x8SrgbBlock;
+  case VK_FORMAT_ASTC_10x5_UNORM_BLOCK: return Format::ASTC10x5UnormBlock;
+  case VK_FORMAT_ASTC_10x5_SRGB_BLOCK: return Format::ASTC10x5SrgbBlock;
+  case VK_FORMAT_ASTC_10x6_UNORM_BLOCK: return Format::ASTC10x6UnormBlock;
+  case VK_FORMAT_ASTC_10x6_SRGB_BLOCK: return Format::ASTC10x6SrgbBlock;
+  case VK_FORMAT_ASTC_10x8_UNORM_BLOCK: return Format::ASTC10x8UnormBlock;
+  case VK_FORMAT_ASTC_10x8_SRGB_BLOCK: return Format::ASTC10x8SrgbBlock;
+  case VK_FORMAT_ASTC_10x10_UNORM_BLOCK: return Format::ASTC10x10UnormBlock;
+  case VK_FORMAT_ASTC_10x10_SRGB_BLOCK: return Format::ASTC10x10SrgbBlock;
+  case VK_FORMAT_ASTC_12x10_UNORM_BLOCK: return Format::ASTC12x10UnormBlock;
+  case VK_FORMAT_ASTC_12x10_SRGB_BLOCK: return Format::ASTC12x10SrgbBlock;
+  case VK_FORMAT_ASTC_12x12_UNORM_BLOCK: return Format::ASTC12x12UnormBlock;
+  case VK_FORMAT_ASTC_12x12_SRGB_BLOCK: return Format::ASTC12x12SrgbBlock;
   default: {
     throw InvalidUse("No conversion");
   }
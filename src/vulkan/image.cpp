@@ -9,7 +9,10 @@
 #include "purrr/vulkan/sampler.hpp"
 #include "purrr/vulkan/format.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <numeric>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace purrr::vulkan {
@@ -23,29 +26,132 @@ VkImageTiling vkImageTiling(ImageTiling tiling) {
   throw Unreachable();
 }
 
-Image::Image(Context *context, const ImageInfo &info)
-  : mContext(context), mUsage(info.usage) {
+VkImageType vkImageType(ImageType type) {
+  switch (type) {
+  case ImageType::Image2D:
+  case ImageType::Image2DArray:
+  case ImageType::ImageCube:
+  case ImageType::ImageCubeArray: return VK_IMAGE_TYPE_2D;
+  case ImageType::Image3D: return VK_IMAGE_TYPE_3D;
+  }
+
+  throw Unreachable();
+}
+
+VkImageViewType vkImageViewType(ImageType type) {
+  switch (type) {
+  case ImageType::Image2D: return VK_IMAGE_VIEW_TYPE_2D;
+  case ImageType::Image2DArray: return VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  case ImageType::ImageCube: return VK_IMAGE_VIEW_TYPE_CUBE;
+  case ImageType::ImageCubeArray: return VK_IMAGE_VIEW_TYPE_CUBE_ARRAY;
+  case ImageType::Image3D: return VK_IMAGE_VIEW_TYPE_3D;
+  }
+
+  throw Unreachable();
+}
+
+Image::Image(Context *context, const ImageInfo &info, bool allocate)
+  : mContext(context), mFormat(info.format), mSampler(info.sampler), mUsage(info.usage) {
   createImage(info);
+  if (!allocate) return;
   allocateMemory();
-  createImageView(info);
-  if (info.usage.texture && info.sampler) allocateDescriptorSet(info.sampler);
+  vkBindImageMemory(mContext->getDevice(), mImage, mMemory, 0);
+  createViews();
 }
 
 Image::~Image() {
+  if (mInputDescriptorSet)
+    vkFreeDescriptorSets(mContext->getDevice(), mContext->getDescriptorPool(), 1, &mInputDescriptorSet);
   if (mDescriptorSet) vkFreeDescriptorSets(mContext->getDevice(), mContext->getDescriptorPool(), 1, &mDescriptorSet);
+  if (mAttachmentView) vkDestroyImageView(mContext->getDevice(), mAttachmentView, VK_NULL_HANDLE);
   if (mImageView) vkDestroyImageView(mContext->getDevice(), mImageView, VK_NULL_HANDLE);
-  if (mMemory) vkFreeMemory(mContext->getDevice(), mMemory, VK_NULL_HANDLE);
+  if (mMemory) mContext->freeMemory(mMemory);
   if (mImage) vkDestroyImage(mContext->getDevice(), mImage, VK_NULL_HANDLE);
 }
 
-void Image::copyData(size_t width, size_t height, size_t size, const void *data) {
+void Image::copyData(size_t width, size_t height, size_t size, const void *data, uint32_t mipLevel, uint32_t layer) {
+  if (size < formatRegionSize(mFormat, width, height)) throw InvalidUse("Copied data is smaller than the region");
+
+  ImageRegion region{};
+  region.x        = 0;
+  region.y        = 0;
+  region.width    = width;
+  region.height   = height;
+  region.layer    = layer;
+  region.mipLevel = mipLevel;
+  region.rowPitch = 0;
+  region.data     = data;
+  copyRegions(&region, 1);
+}
+
+void Image::copyRegions(const ImageRegion *regions, size_t regionCount) {
+  if (regionCount == 0) return;
+  TraceSpan span(mContext->getTracer(), "Image upload");
+
+  FormatBlock  block     = formatBlock(mFormat);
+  VkDeviceSize alignment = std::lcm<VkDeviceSize>(block.size, 4); // Required of every buffer offset
+
+  std::vector<VkBufferImageCopy> copies(regionCount);
+  std::vector<VkDeviceSize>      rowSizes(regionCount);
+  VkDeviceSize                   size = 0;
+  for (size_t i = 0; i < regionCount; ++i) {
+    const ImageRegion &region = regions[i];
+    if (region.mipLevel >= mMipLevels) throw InvalidUse("Image has no such mip level");
+
+    uint32_t levelWidth  = std::max(mExtent.width >> region.mipLevel, 1U);
+    uint32_t levelHeight = std::max(mExtent.height >> region.mipLevel, 1U);
+    if (region.x + region.width > levelWidth || region.y + region.height > levelHeight)
+      throw InvalidUse("Copied region is outside of the mip level");
+
+    // Slices of 3D images are addressed through the offset, everything else through the subresource
+    bool     volume     = mType == ImageType::Image3D;
+    uint32_t layerCount = volume ? std::max(mExtent.depth >> region.mipLevel, 1U) : mArrayLayers;
+    if (region.layer >= layerCount) throw InvalidUse("Image has no such layer");
+
+    // Compressed data comes in whole blocks, only the edges of a level may end in a partial one
+    if (region.x % block.width || region.y % block.height ||
+        (region.width % block.width && region.x + region.width != levelWidth) ||
+        (region.height % block.height && region.y + region.height != levelHeight))
+      throw InvalidUse("Copied region is not aligned to the format blocks");
+
+    rowSizes[i] = formatRegionSize(mFormat, region.width, 1);
+    if (region.rowPitch != 0 && region.rowPitch < rowSizes[i]) throw InvalidUse("Row pitch is smaller than a row");
+
+    size = (size + alignment - 1) / alignment * alignment;
+
+    copies[i].bufferOffset      = size;
+    copies[i].bufferRowLength   = 0;
+    copies[i].bufferImageHeight = 0;
+    copies[i].imageSubresource  = { VK_IMAGE_ASPECT_COLOR_BIT, region.mipLevel, volume ? 0 : region.layer, 1 };
+    copies[i].imageOffset       = { static_cast<int32_t>(region.x),
+                                    static_cast<int32_t>(region.y),
+                                    volume ? static_cast<int32_t>(region.layer) : 0 };
+    copies[i].imageExtent       = { static_cast<uint32_t>(region.width), static_cast<uint32_t>(region.height), 1 };
+
+    size += formatRegionSize(mFormat, region.width, region.height);
+  }
+
   VkBuffer       stagingBuffer = VK_NULL_HANDLE;
   VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
   Buffer::createBuffer(mContext, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false, &stagingBuffer, &stagingMemory);
-
-  void *stagingData = nullptr;
-  vkMapMemory(mContext->getDevice(), stagingMemory, 0, size, 0, &stagingData);
-  memcpy(stagingData, data, size);
+  mContext->getCurrentStats().stagingAllocations += 1;
+  mContext->getCurrentStats().bytesUploaded      += size;
+
+  // Rows are packed tightly, so only the copied texels travel to the device
+  uint8_t *stagingData = nullptr;
+  vkMapMemory(mContext->getDevice(), stagingMemory, 0, size, 0, reinterpret_cast<void **>(&stagingData));
+  for (size_t i = 0; i < regionCount; ++i) {
+    const uint8_t *source   = reinterpret_cast<const uint8_t *>(regions[i].data);
+    size_t         rowCount = (regions[i].height + block.height - 1) / block.height;
+    size_t         rowPitch = regions[i].rowPitch ? regions[i].rowPitch : rowSizes[i];
+    if (rowPitch == rowSizes[i]) {
+      memcpy(stagingData + copies[i].bufferOffset, source, rowCount * rowSizes[i]);
+      continue;
+    }
+
+    for (size_t row = 0; row < rowCount; ++row)
+      memcpy(stagingData + copies[i].bufferOffset + row * rowSizes[i], source + row * rowPitch, rowSizes[i]);
+  }
   vkUnmapMemory(mContext->getDevice(), stagingMemory);
 
   VkCommandBuffer commandBuffer = mContext->beginSingleTimeCommands();
@@ -60,39 +166,243 @@ void Image::copyData(size_t width, size_t height, size_t size, const void *data)
       VK_ACCESS_TRANSFER_WRITE_BIT,
       commandBuffer);
 
-  VkBufferImageCopy region{};
-  region.bufferOffset      = 0;
-  region.bufferRowLength   = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource  = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
-  region.imageOffset       = {};
-  region.imageExtent       = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
-
-  vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  vkCmdCopyBufferToImage(
+      commandBuffer,
+      stagingBuffer,
+      mImage,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(copies.size()),
+      copies.data());
 
-  transitionImageLayout(oldLayout, oldStage, oldAccess, commandBuffer);
+  // Images that were never used have no layout to go back to
+  if (oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) transitionImageLayout(oldLayout, oldStage, oldAccess, commandBuffer);
 
   mContext->submitSingleTimeCommands(commandBuffer);
 
-  vkFreeMemory(mContext->getDevice(), stagingMemory, VK_NULL_HANDLE);
+  mContext->freeMemory(stagingMemory);
   vkDestroyBuffer(mContext->getDevice(), stagingBuffer, VK_NULL_HANDLE);
 }
 
+std::future<std::vector<uint8_t>> Image::readback(
+    size_t x, size_t y, size_t width, size_t height, uint32_t layer, uint32_t mipLevel) {
+  if (mipLevel >= mMipLevels) throw InvalidUse("Image has no such mip level");
+  if (x + width > std::max(mExtent.width >> mipLevel, 1U) || y + height > std::max(mExtent.height >> mipLevel, 1U))
+    throw InvalidUse("Read area is outside of the mip level");
+
+  bool     volume     = mType == ImageType::Image3D;
+  uint32_t layerCount = volume ? std::max(mExtent.depth >> mipLevel, 1U) : mArrayLayers;
+  if (layer >= layerCount) throw InvalidUse("Image has no such layer");
+
+  FormatBlock block = formatBlock(mFormat);
+  if (x % block.width || y % block.height) throw InvalidUse("Read area is not aligned to the format blocks");
+  if (mUsage.transient) throw InvalidUse("Transient images cannot be read back");
+
+  VkBufferImageCopy copy{};
+  copy.bufferOffset      = 0;
+  copy.bufferRowLength   = 0;
+  copy.bufferImageHeight = 0;
+  copy.imageSubresource  = { VK_IMAGE_ASPECT_COLOR_BIT, mipLevel, volume ? 0 : layer, 1 };
+  copy.imageOffset       = { static_cast<int32_t>(x),
+                             static_cast<int32_t>(y),
+                             volume ? static_cast<int32_t>(layer) : 0 };
+  copy.imageExtent       = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+
+  return mContext->getReadbackRing()->read(
+      formatRegionSize(mFormat, width, height),
+      std::lcm<VkDeviceSize>(block.size, 4),
+      [this, copy](VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) mutable {
+        copy.bufferOffset = offset;
+        copyToBuffer(commandBuffer, buffer, copy);
+      });
+}
+
+void Image::copyToBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, const VkBufferImageCopy &copy) {
+  VkImageLayout        oldLayout = mLayout;
+  VkPipelineStageFlags oldStage  = mStage;
+  VkAccessFlags        oldAccess = mAccess;
+
+  transitionImageLayout(
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_READ_BIT,
+      commandBuffer);
+
+  vkCmdCopyImageToBuffer(commandBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &copy);
+
+  if (oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) transitionImageLayout(oldLayout, oldStage, oldAccess, commandBuffer);
+}
+
+void Image::generateMipmaps() {
+  if (mMipLevels == 1) return;
+
+  VkFormatProperties formatProperties{};
+  vkGetPhysicalDeviceFormatProperties(mContext->getPhysicalDevice(), vkFormat(mFormat), &formatProperties);
+  VkFormatFeatureFlags features = formatProperties.optimalTilingFeatures;
+  if (!(features & VK_FORMAT_FEATURE_BLIT_SRC_BIT) || !(features & VK_FORMAT_FEATURE_BLIT_DST_BIT))
+    throw InvalidUse("Image format does not support mipmap generation");
+
+  // Formats without linear filtering still get a chain, only a blockier one
+  VkFilter filter = VK_FILTER_NEAREST;
+  if (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) filter = VK_FILTER_LINEAR;
+
+  VkCommandBuffer commandBuffer = mContext->beginSingleTimeCommands();
+
+  VkImageLayout        oldLayout = mLayout;
+  VkPipelineStageFlags oldStage  = mStage;
+  VkAccessFlags        oldAccess = mAccess;
+
+  // The first level keeps its contents, the rest is overwritten
+  transitionImageLayout(
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      commandBuffer);
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.pNext               = VK_NULL_HANDLE;
+  barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT;
+  barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image               = mImage;
+  barrier.subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, mArrayLayers };
+
+  int32_t width  = static_cast<int32_t>(mExtent.width);
+  int32_t height = static_cast<int32_t>(mExtent.height);
+  int32_t depth  = static_cast<int32_t>(mExtent.depth);
+  for (uint32_t level = 1; level < mMipLevels; ++level) {
+    barrier.subresourceRange.baseMipLevel = level - 1;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0,
+        VK_NULL_HANDLE,
+        0,
+        VK_NULL_HANDLE,
+        1,
+        &barrier);
+
+    int32_t nextWidth  = std::max(width / 2, 1);
+    int32_t nextHeight = std::max(height / 2, 1);
+    int32_t nextDepth  = std::max(depth / 2, 1);
+
+    VkImageBlit blit{};
+    blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, mArrayLayers };
+    blit.srcOffsets[0]  = {};
+    blit.srcOffsets[1]  = { width, height, depth };
+    blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, mArrayLayers };
+    blit.dstOffsets[0]  = {};
+    blit.dstOffsets[1]  = { nextWidth, nextHeight, nextDepth };
+
+    vkCmdBlitImage(
+        commandBuffer,
+        mImage,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        mImage,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &blit,
+        filter);
+
+    width  = nextWidth;
+    height = nextHeight;
+    depth  = nextDepth;
+  }
+
+  // Leaves every level in the same layout so the image is tracked as a whole again
+  barrier.subresourceRange.baseMipLevel = mMipLevels - 1;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      VK_NULL_HANDLE,
+      0,
+      VK_NULL_HANDLE,
+      1,
+      &barrier);
+  assumeLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+  if (oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) transitionImageLayout(oldLayout, oldStage, oldAccess, commandBuffer);
+
+  mContext->submitSingleTimeCommands(commandBuffer);
+}
+
 void Image::createImage(const ImageInfo &info) {
+  mType        = info.type;
+  mExtent      = { static_cast<uint32_t>(info.width), static_cast<uint32_t>(info.height), 1 };
+  mArrayLayers = 1;
+
+  VkImageCreateFlags flags = 0;
+  switch (mType) {
+  case ImageType::Image2D: break;
+  case ImageType::Image2DArray: mArrayLayers = info.layers; break;
+  case ImageType::ImageCube:
+  case ImageType::ImageCubeArray:
+    if (mExtent.width != mExtent.height) throw InvalidUse("Cube images have to be square");
+    if (mType == ImageType::ImageCubeArray && !mContext->getEnabledFeatures().imageCubeArray)
+      throw InvalidUse("Device does not support cube arrays");
+    mArrayLayers = 6 * (mType == ImageType::ImageCube ? 1 : info.layers);
+    flags        = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    break;
+  case ImageType::Image3D:
+    if (info.usage.renderTarget) throw InvalidUse("3D images cannot be render targets");
+    mExtent.depth = static_cast<uint32_t>(info.depth);
+    break;
+  }
+  if (mArrayLayers == 0 || mExtent.depth == 0) throw InvalidUse("Images require at least one layer");
+
+  mMipLevels = info.mipLevels;
+  if (mMipLevels == FULL_MIP_CHAIN) {
+    mMipLevels = 1;
+    while ((std::max({ mExtent.width, mExtent.height, mExtent.depth }) >> mMipLevels) > 0) ++mMipLevels;
+  }
+
   VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-  if (info.usage.texture) usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
-  if (info.usage.renderTarget) usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  if (info.usage.texture) {
+    // Compressed formats depend on optional device features
+    VkFormatProperties formatProperties{};
+    vkGetPhysicalDeviceFormatProperties(mContext->getPhysicalDevice(), vkFormat(info.format), &formatProperties);
+    VkFormatFeatureFlags features = (info.tiling == ImageTiling::Linear) ? formatProperties.linearTilingFeatures
+                                                                         : formatProperties.optimalTilingFeatures;
+    if (!(features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) throw InvalidUse("Device cannot sample the image format");
+    usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+  }
+
+  if (info.usage.renderTarget) {
+    FormatBlock block = formatBlock(info.format);
+    if (block.width != 1 || block.height != 1) throw InvalidUse("Compressed images cannot be render targets");
+    usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  }
+
+  if (info.usage.inputAttachment) {
+    if (!info.usage.renderTarget) throw InvalidUse("Input attachments have to be render targets");
+    usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+  }
+
+  if (info.usage.transient) {
+    if (!info.usage.renderTarget || info.usage.texture) throw InvalidUse("Transient images can only be render targets");
+    if (mMipLevels != 1 || mArrayLayers != 1) throw InvalidUse("Transient images cannot have mip levels or layers");
+    usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    if (info.usage.inputAttachment) usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+  }
 
   VkImageCreateInfo createInfo{};
   createInfo.sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   createInfo.pNext                 = VK_NULL_HANDLE;
-  createInfo.flags                 = 0;
-  createInfo.imageType             = VK_IMAGE_TYPE_2D;
+  createInfo.flags                 = flags;
+  createInfo.imageType             = vkImageType(mType);
   createInfo.format                = vkFormat(info.format);
-  createInfo.extent                = { static_cast<uint32_t>(info.width), static_cast<uint32_t>(info.height), 1 };
-  createInfo.mipLevels             = 1;
-  createInfo.arrayLayers           = 1;
+  createInfo.extent                = mExtent;
+  createInfo.mipLevels             = mMipLevels;
+  createInfo.arrayLayers           = mArrayLayers;
   createInfo.samples               = VK_SAMPLE_COUNT_1_BIT;
   createInfo.tiling                = vkImageTiling(info.tiling);
   createInfo.usage                 = usage;
@@ -102,32 +412,61 @@ void Image::createImage(const ImageInfo &info) {
   createInfo.initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED;
 
   expectResult("Image creation", vkCreateImage(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mImage));
+  mContext->setObjectName(VK_OBJECT_TYPE_IMAGE, reinterpret_cast<uint64_t>(mImage), info.name);
 }
 
 void Image::allocateMemory() {
   VkMemoryRequirements memoryRequirements{};
   vkGetImageMemoryRequirements(mContext->getDevice(), mImage, &memoryRequirements);
 
+  VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  if (mUsage.transient) properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
   VkMemoryAllocateInfo allocateInfo{};
   allocateInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
   allocateInfo.pNext          = VK_NULL_HANDLE;
   allocateInfo.allocationSize = memoryRequirements.size;
   allocateInfo.memoryTypeIndex =
-      mContext->findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      mContext->findMemoryType(memoryRequirements.memoryTypeBits, properties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-  expectResult("Memory allocation", vkAllocateMemory(mContext->getDevice(), &allocateInfo, nullptr, &mMemory));
+  mMemory = mContext->allocateMemory(allocateInfo);
+}
 
-  vkBindImageMemory(mContext->getDevice(), mImage, mMemory, 0);
+void Image::createViews() {
+  createImageView();
+  if (mUsage.renderTarget && (mMipLevels != 1 || mArrayLayers != 1)) createAttachmentView();
+  if (mUsage.texture && mSampler) allocateDescriptorSet(mSampler);
+  if (mUsage.inputAttachment) allocateInputDescriptorSet();
 }
 
-void Image::createImageView(const ImageInfo &info) {
+void Image::createImageView() {
+  VkImageViewCreateInfo createInfo{};
+  createInfo.sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  createInfo.pNext            = VK_NULL_HANDLE;
+  createInfo.flags            = 0;
+  createInfo.image            = mImage;
+  createInfo.viewType         = vkImageViewType(mType);
+  createInfo.format           = vkFormat(mFormat);
+  createInfo.components       = { VK_COMPONENT_SWIZZLE_R,
+                                  VK_COMPONENT_SWIZZLE_G,
+                                  VK_COMPONENT_SWIZZLE_B,
+                                  VK_COMPONENT_SWIZZLE_A };
+  createInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mMipLevels, 0, mArrayLayers };
+
+  expectResult(
+      "Image view creation",
+      vkCreateImageView(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mImageView));
+}
+
+void Image::createAttachmentView() {
+  // Framebuffers and input attachments only accept views of a single level and layer
   VkImageViewCreateInfo createInfo{};
   createInfo.sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
   createInfo.pNext            = VK_NULL_HANDLE;
   createInfo.flags            = 0;
   createInfo.image            = mImage;
   createInfo.viewType         = VK_IMAGE_VIEW_TYPE_2D;
-  createInfo.format           = vkFormat(info.format);
+  createInfo.format           = vkFormat(mFormat);
   createInfo.components       = { VK_COMPONENT_SWIZZLE_R,
                                   VK_COMPONENT_SWIZZLE_G,
                                   VK_COMPONENT_SWIZZLE_B,
@@ -136,7 +475,7 @@ void Image::createImageView(const ImageInfo &info) {
 
   expectResult(
       "Image view creation",
-      vkCreateImageView(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mImageView));
+      vkCreateImageView(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mAttachmentView));
 }
 
 void Image::allocateDescriptorSet(purrr::Sampler *sampler) {
@@ -181,36 +520,103 @@ void Image::allocateDescriptorSet(purrr::Sampler *sampler) {
       VK_ACCESS_SHADER_READ_BIT);
 }
 
+void Image::allocateInputDescriptorSet() {
+  auto layout = mContext->getInputDescriptorSetLayout();
+
+  VkDescriptorSetAllocateInfo allocateInfo{};
+  allocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocateInfo.pNext              = VK_NULL_HANDLE;
+  allocateInfo.descriptorPool     = mContext->getDescriptorPool();
+  allocateInfo.descriptorSetCount = 1;
+  allocateInfo.pSetLayouts        = &layout;
+
+  expectResult(
+      "Descriptor set allocation",
+      vkAllocateDescriptorSets(mContext->getDevice(), &allocateInfo, &mInputDescriptorSet));
+
+  VkDescriptorImageInfo imageInfo{};
+  imageInfo.sampler     = VK_NULL_HANDLE;
+  imageInfo.imageView   = getAttachmentView();
+  imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  VkWriteDescriptorSet write{};
+  write.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.pNext            = VK_NULL_HANDLE;
+  write.dstSet           = mInputDescriptorSet;
+  write.dstBinding       = 0;
+  write.dstArrayElement  = 0;
+  write.descriptorCount  = 1;
+  write.descriptorType   = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+  write.pImageInfo       = &imageInfo;
+  write.pBufferInfo      = VK_NULL_HANDLE;
+  write.pTexelBufferView = VK_NULL_HANDLE;
+
+  vkUpdateDescriptorSets(mContext->getDevice(), 1, &write, 0, VK_NULL_HANDLE);
+}
+
+void Image::bindMemory(VkDeviceMemory memory, VkDeviceSize offset) {
+  if (mImageView != VK_NULL_HANDLE) throw InvalidUse("Image memory is already bound");
+
+  expectResult("Image memory binding", vkBindImageMemory(mContext->getDevice(), mImage, memory, offset));
+  createViews();
+}
+
+VkMemoryRequirements Image::getMemoryRequirements() const {
+  VkMemoryRequirements memoryRequirements{};
+  vkGetImageMemoryRequirements(mContext->getDevice(), mImage, &memoryRequirements);
+  return memoryRequirements;
+}
+
 void Image::transitionImageLayout(
     VkImageLayout dstLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkCommandBuffer commandBuffer) {
-  if (mLayout == dstLayout && mStage == dstStage && mAccess == dstAccess) return;
+  VkImageMemoryBarrier barrier{};
+  VkPipelineStageFlags srcStage = 0;
+  if (!prepareTransition(dstLayout, dstStage, dstAccess, &barrier, &srcStage)) return;
 
   VkCommandBuffer cmdBuf = commandBuffer;
   if (cmdBuf == VK_NULL_HANDLE) {
     cmdBuf = mContext->beginSingleTimeCommands();
   }
 
-  VkImageMemoryBarrier barrier{};
-  barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.pNext               = VK_NULL_HANDLE;
-  barrier.srcAccessMask       = mAccess;
-  barrier.dstAccessMask       = dstAccess;
-  barrier.oldLayout           = mLayout;
-  barrier.newLayout           = dstLayout;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image               = mImage;
-  barrier.subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-
-  vkCmdPipelineBarrier(cmdBuf, mStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+  vkCmdPipelineBarrier(cmdBuf, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
   if (commandBuffer == VK_NULL_HANDLE) {
     mContext->submitSingleTimeCommands(cmdBuf);
   }
+}
+
+bool Image::prepareTransition(
+    VkImageLayout         dstLayout,
+    VkPipelineStageFlags  dstStage,
+    VkAccessFlags         dstAccess,
+    VkImageMemoryBarrier *barrier,
+    VkPipelineStageFlags *srcStage) {
+  if (mLayout == dstLayout && mStage == dstStage && mAccess == dstAccess) return false;
+
+  barrier->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier->pNext               = VK_NULL_HANDLE;
+  barrier->srcAccessMask       = mAccess;
+  barrier->dstAccessMask       = dstAccess;
+  barrier->oldLayout           = mLayout;
+  barrier->newLayout           = dstLayout;
+  barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier->image               = mImage;
+  barrier->subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mMipLevels, 0, mArrayLayers };
+
+  *srcStage |= mStage;
 
   mLayout = dstLayout;
   mStage  = dstStage;
   mAccess = dstAccess;
+
+  return true;
+}
+
+void Image::assumeLayout(VkImageLayout layout, VkPipelineStageFlags stage, VkAccessFlags access) {
+  mLayout = layout;
+  mStage  = stage;
+  mAccess = access;
 }
 
 } // namespace purrr::vulkan
@@ -0,0 +1,119 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#include "purrr/vulkan/exceptions.hpp"
+
+#include "purrr/vulkan/profiler.hpp"
+#include "purrr/vulkan/context.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace purrr::vulkan {
+
+static_assert(GpuProfiler::FRAME_COUNT > Context::MAX_FRAMES_IN_FLIGHT);
+
+GpuProfiler::GpuProfiler(Context *context)
+  : mContext(context) {
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(mContext->getPhysicalDevice(), &properties);
+  mPeriod = properties.limits.timestampPeriod;
+
+  uint32_t validBits = timestampBits(mContext->getPhysicalDevice(), mContext->getQueueFamilyIndex());
+  mMask              = (validBits >= 64) ? ~0ULL : ((1ULL << validBits) - 1);
+
+  VkQueryPoolCreateInfo createInfo{};
+  createInfo.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  createInfo.pNext              = VK_NULL_HANDLE;
+  createInfo.flags              = 0;
+  createInfo.queryType          = VK_QUERY_TYPE_TIMESTAMP;
+  createInfo.queryCount         = FRAME_COUNT * MAX_SCOPES * 2;
+  createInfo.pipelineStatistics = 0;
+
+  expectResult(
+      "Query pool creation",
+      vkCreateQueryPool(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mQueryPool));
+}
+
+GpuProfiler::~GpuProfiler() {
+  if (mQueryPool) vkDestroyQueryPool(mContext->getDevice(), mQueryPool, VK_NULL_HANDLE);
+}
+
+uint32_t GpuProfiler::timestampBits(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex) {
+  uint32_t count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, VK_NULL_HANDLE);
+
+  std::vector<VkQueueFamilyProperties> families(count);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+
+  return families[queueFamilyIndex].timestampValidBits;
+}
+
+bool GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint64_t frameIndex) {
+  mSlot          = static_cast<uint32_t>(frameIndex % FRAME_COUNT);
+  bool collected = mFrames[mSlot].pending && collect(mSlot);
+
+  mFrames[mSlot].scopes.clear();
+  mFrames[mSlot].index = frameIndex;
+  mOpenScopes.clear();
+  vkCmdResetQueryPool(commandBuffer, mQueryPool, mSlot * MAX_SCOPES * 2, MAX_SCOPES * 2);
+  return collected;
+}
+
+void GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char *name) {
+  Frame &frame = mFrames[mSlot];
+  mOpenScopes.push_back(frame.scopes.size());
+  frame.scopes.push_back({ name, static_cast<uint32_t>(mOpenScopes.size() - 1) });
+  if (frame.scopes.size() > MAX_SCOPES) return;
+
+  uint32_t query = (mSlot * MAX_SCOPES + static_cast<uint32_t>(mOpenScopes.back())) * 2;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, query);
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer) {
+  size_t scope = mOpenScopes.back();
+  mOpenScopes.pop_back();
+  mFrames[mSlot].pending = true;
+  if (scope >= MAX_SCOPES) return;
+
+  uint32_t query = (mSlot * MAX_SCOPES + static_cast<uint32_t>(scope)) * 2 + 1;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, query);
+}
+
+bool GpuProfiler::collect(uint32_t slot) {
+  Frame &frame = mFrames[slot];
+  frame.pending = false;
+
+  uint32_t scopeCount = static_cast<uint32_t>(std::min<size_t>(frame.scopes.size(), MAX_SCOPES));
+  if (scopeCount == 0) return false;
+
+  // Every frame using the slot before finished, the results are available without waiting
+  std::vector<uint64_t> timestamps(scopeCount * 2);
+  VkResult              result = vkGetQueryPoolResults(
+      mContext->getDevice(),
+      mQueryPool,
+      slot * MAX_SCOPES * 2,
+      scopeCount * 2,
+      timestamps.size() * sizeof(uint64_t),
+      timestamps.data(),
+      sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT);
+  if (result == VK_NOT_READY) return false;
+  expectResult("Query results", result);
+
+  mTimings.clear();
+  for (uint32_t i = 0; i < scopeCount; ++i) {
+    timestamps[i * 2] &= mMask;
+    timestamps[i * 2 + 1] &= mMask;
+    uint64_t ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & mMask;
+    mTimings.push_back({ frame.scopes[i].name, frame.scopes[i].depth, static_cast<double>(ticks) * mPeriod * 1e-6 });
+  }
+
+  mTimestamps   = std::move(timestamps);
+  mTimingsFrame = frame.index;
+  return true;
+}
+
+} // namespace purrr::vulkan
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
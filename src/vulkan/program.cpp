@@ -83,7 +83,10 @@ Shader::~Shader() {
 }
 
 Program::Program(IRenderTarget *renderTarget, Context *context, const ProgramInfo &info)
-  : mRenderTarget(renderTarget), mContext(context) {
+  : mRenderTarget(renderTarget), mContext(context), mSubpass(info.subpass) {
+  if (mSubpass >= mRenderTarget->getSubpassCount()) throw InvalidUse("Render target has no such subpass");
+
+  TraceSpan span(mContext->getTracer(), "Pipeline creation");
   createLayout(info);
   createPipeline(info);
 }
@@ -93,6 +96,13 @@ Program::~Program() {
   if (mPipeline) vkDestroyPipeline(mContext->getDevice(), mPipeline, VK_NULL_HANDLE);
 }
 
+bool Program::compatibleWith(IRenderTarget *renderTarget) const {
+  if (renderTarget == mRenderTarget) return true;
+  if (mColorFormats.empty()) return mRenderTarget->renderPassCompatible(renderTarget);
+  if (renderTarget->getRenderPass() != VK_NULL_HANDLE) return false;
+  return renderTarget->getColorFormats() == mColorFormats;
+}
+
 void Program::createLayout(const ProgramInfo &info) {
   std::vector<VkDescriptorSetLayout> layouts(info.slotCount);
   for (uint32_t i = 0; i < info.slotCount; ++i) {
@@ -106,6 +116,9 @@ void Program::createLayout(const ProgramInfo &info) {
     case ProgramSlot::StorageBuffer: {
       layouts[i] = mContext->getStorageDescriptorSetLayout();
     } break;
+    case ProgramSlot::InputAttachment: {
+      layouts[i] = mContext->getInputDescriptorSetLayout();
+    } break;
     }
   }
 
@@ -241,14 +254,18 @@ void Program::createPipeline(const ProgramInfo &info) {
   colorBlendAttachmentState.colorWriteMask      = static_cast<VkColorComponentFlags>(
       VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
 
+  // Every color attachment of the subpass needs its own blend state
+  std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachmentStates(
+      mRenderTarget->getColorAttachmentCount(mSubpass), colorBlendAttachmentState);
+
   VkPipelineColorBlendStateCreateInfo colorBlendState{};
   colorBlendState.sType             = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
   colorBlendState.pNext             = VK_NULL_HANDLE;
   colorBlendState.flags             = 0;
   colorBlendState.logicOpEnable     = VK_FALSE;
   colorBlendState.logicOp           = VK_LOGIC_OP_NO_OP;
-  colorBlendState.attachmentCount   = 1;
-  colorBlendState.pAttachments      = &colorBlendAttachmentState;
+  colorBlendState.attachmentCount   = static_cast<uint32_t>(colorBlendAttachmentStates.size());
+  colorBlendState.pAttachments      = colorBlendAttachmentStates.data();
   colorBlendState.blendConstants[0] = 1.0f;
   colorBlendState.blendConstants[1] = 1.0f;
   colorBlendState.blendConstants[2] = 1.0f;
@@ -280,13 +297,29 @@ void Program::createPipeline(const ProgramInfo &info) {
   createInfo.pDynamicState       = &dynamicState;
   createInfo.layout              = mLayout;
   createInfo.renderPass          = mRenderTarget->getRenderPass();
-  createInfo.subpass             = 0;
+  createInfo.subpass             = mSubpass;
   createInfo.basePipelineHandle  = VK_NULL_HANDLE;
   createInfo.basePipelineIndex   = 0;
 
+  VkPipelineRenderingCreateInfoKHR renderingInfo{};
+  if (createInfo.renderPass == VK_NULL_HANDLE) {
+    mColorFormats = mRenderTarget->getColorFormats();
+
+    renderingInfo.sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.pNext                   = VK_NULL_HANDLE;
+    renderingInfo.viewMask                = 0;
+    renderingInfo.colorAttachmentCount    = static_cast<uint32_t>(mColorFormats.size());
+    renderingInfo.pColorAttachmentFormats = mColorFormats.data();
+    renderingInfo.depthAttachmentFormat   = VK_FORMAT_UNDEFINED;
+    renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    createInfo.pNext                      = &renderingInfo;
+  }
+
   expectResult(
       "Pipeline creation",
       vkCreateGraphicsPipelines(mContext->getDevice(), VK_NULL_HANDLE, 1, &createInfo, VK_NULL_HANDLE, &mPipeline));
+  mContext->setObjectName(VK_OBJECT_TYPE_PIPELINE, reinterpret_cast<uint64_t>(mPipeline), info.name);
+  ++mContext->getCurrentStats().pipelineCompilations;
 }
 
 } // namespace purrr::vulkan
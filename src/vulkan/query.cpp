@@ -0,0 +1,226 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#include "purrr/exceptions.hpp"
+
+#include "purrr/vulkan/exceptions.hpp"
+
+#include "purrr/vulkan/query.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace purrr::vulkan {
+
+static_assert(sizeof(PipelineStatistics) == 5 * sizeof(uint64_t));
+
+// Results are written in the order of the bits, matching PipelineStatistics
+static constexpr VkQueryPipelineStatisticFlags STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+Query::Query(Context *context, QueryType type)
+  : mContext(context), mType(type) {
+  if (mType == QueryType::PipelineStatistics) {
+    if (!mContext->getEnabledFeatures().pipelineStatisticsQuery)
+      throw std::runtime_error("Pipeline statistics queries are not supported by the device");
+    mValueCount = sizeof(PipelineStatistics) / sizeof(uint64_t);
+  }
+
+  createQueryPool();
+  createBuffer();
+}
+
+Query::~Query() {
+  if (mMemory) {
+    vkUnmapMemory(mContext->getDevice(), mMemory);
+    mContext->freeMemory(mMemory);
+  }
+  if (mBuffer) vkDestroyBuffer(mContext->getDevice(), mBuffer, VK_NULL_HANDLE);
+  if (mQueryPool) vkDestroyQueryPool(mContext->getDevice(), mQueryPool, VK_NULL_HANDLE);
+}
+
+bool Query::getSamples(uint64_t &samples) const {
+  if (mType != QueryType::Occlusion) throw InvalidUse("getSamples() called on a pipeline statistics query");
+  return read(&samples);
+}
+
+bool Query::getStatistics(PipelineStatistics &statistics) const {
+  if (mType != QueryType::PipelineStatistics) throw InvalidUse("getStatistics() called on an occlusion query");
+
+  uint64_t values[sizeof(PipelineStatistics) / sizeof(uint64_t)];
+  if (!read(values)) return false;
+
+  statistics.vertexShaderInvocations   = values[0];
+  statistics.clippingInvocations       = values[1];
+  statistics.clippingPrimitives        = values[2];
+  statistics.fragmentShaderInvocations = values[3];
+  statistics.computeShaderInvocations  = values[4];
+  return true;
+}
+
+void Query::begin(VkCommandBuffer commandBuffer, uint64_t frameIndex) {
+  if (mActive) throw InvalidUse("Query began twice");
+  if (mLastFrame == frameIndex) throw InvalidUse("Queries can only be used once per frame");
+
+  mSlot          = static_cast<uint32_t>(mUses++ % SLOT_COUNT);
+  mFrames[mSlot] = 0;
+  mLastFrame     = frameIndex;
+  mActive        = true;
+
+  VkQueryControlFlags flags = 0;
+  if (mType == QueryType::Occlusion && mContext->getEnabledFeatures().occlusionQueryPrecise)
+    flags = VK_QUERY_CONTROL_PRECISE_BIT;
+
+  vkCmdBeginQuery(commandBuffer, mQueryPool, mSlot, flags);
+}
+
+void Query::end(VkCommandBuffer commandBuffer) {
+  if (!mActive) throw InvalidUse("endQuery() called without beginQuery()");
+  mActive = false;
+
+  vkCmdEndQuery(commandBuffer, mQueryPool, mSlot);
+}
+
+void Query::copyResults(VkCommandBuffer commandBuffer) {
+  // Waits on the device only, the host reads the slot once the frame finished
+  VkDeviceSize size = mValueCount * sizeof(uint64_t);
+  vkCmdCopyQueryPoolResults(
+      commandBuffer,
+      mQueryPool,
+      mSlot,
+      1,
+      mBuffer,
+      mSlot * size,
+      size,
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+  VkPipelineStageFlags dstStage  = VK_PIPELINE_STAGE_HOST_BIT;
+  VkAccessFlags        dstAccess = VK_ACCESS_HOST_READ_BIT;
+  if (mType == QueryType::Occlusion && mContext->usesConditionalRendering()) {
+    vkCmdCopyQueryPoolResults(
+        commandBuffer,
+        mQueryPool,
+        mSlot,
+        1,
+        mBuffer,
+        predicateOffset(mSlot),
+        sizeof(uint32_t),
+        VK_QUERY_RESULT_WAIT_BIT);
+    dstStage  |= VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
+    dstAccess |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
+  }
+
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.pNext               = VK_NULL_HANDLE;
+  barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask       = dstAccess;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer              = mBuffer;
+  barrier.offset              = 0;
+  barrier.size                = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      dstStage,
+      0,
+      0,
+      VK_NULL_HANDLE,
+      1,
+      &barrier,
+      0,
+      VK_NULL_HANDLE);
+
+  // The next use is at least a frame later, its query last ran in a frame that finished before this one began
+  vkCmdResetQueryPool(commandBuffer, mQueryPool, (mSlot + 1) % SLOT_COUNT, 1);
+  mFrames[mSlot] = mLastFrame;
+}
+
+bool Query::getPredicate(VkBuffer &buffer, VkDeviceSize &offset) const {
+  uint32_t latest = SLOT_COUNT;
+  for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot)
+    if (mFrames[slot] != 0 && (latest == SLOT_COUNT || mFrames[slot] > mFrames[latest])) latest = slot;
+  if (latest == SLOT_COUNT) return false;
+
+  buffer = mBuffer;
+  offset = predicateOffset(latest);
+  return true;
+}
+
+void Query::createQueryPool() {
+  VkQueryPoolCreateInfo createInfo{};
+  createInfo.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  createInfo.pNext              = VK_NULL_HANDLE;
+  createInfo.flags              = 0;
+  createInfo.queryType          = (mType == QueryType::Occlusion) ? VK_QUERY_TYPE_OCCLUSION
+                                                                  : VK_QUERY_TYPE_PIPELINE_STATISTICS;
+  createInfo.queryCount         = SLOT_COUNT;
+  createInfo.pipelineStatistics = (mType == QueryType::PipelineStatistics) ? STATISTICS : 0;
+
+  expectResult(
+      "Query pool creation",
+      vkCreateQueryPool(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mQueryPool));
+
+  // Later slots are reset by the use before them
+  VkCommandBuffer commandBuffer = mContext->beginSingleTimeCommands();
+  vkCmdResetQueryPool(commandBuffer, mQueryPool, 0, SLOT_COUNT);
+  mContext->submitSingleTimeCommands(commandBuffer);
+}
+
+void Query::createBuffer() {
+  VkBufferCreateInfo createInfo{};
+  createInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.pNext                 = VK_NULL_HANDLE;
+  createInfo.flags                 = 0;
+  createInfo.size                  = predicateOffset(SLOT_COUNT);
+  createInfo.usage                 = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  createInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+  createInfo.queueFamilyIndexCount = 0;
+  createInfo.pQueueFamilyIndices   = VK_NULL_HANDLE;
+  if (mContext->usesConditionalRendering()) createInfo.usage |= VK_BUFFER_USAGE_CONDITIONAL_RENDERING_BIT_EXT;
+
+  expectResult("Buffer creation", vkCreateBuffer(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mBuffer));
+
+  VkMemoryRequirements memoryRequirements{};
+  vkGetBufferMemoryRequirements(mContext->getDevice(), mBuffer, &memoryRequirements);
+
+  VkMemoryPropertyFlags coherent = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  VkMemoryPropertyFlags cached   = coherent | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+  VkMemoryAllocateInfo allocateInfo{};
+  allocateInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.pNext          = VK_NULL_HANDLE;
+  allocateInfo.allocationSize = memoryRequirements.size;
+  allocateInfo.memoryTypeIndex =
+      mContext->findMemoryType(memoryRequirements.memoryTypeBits, cached, coherent);
+
+  mMemory = mContext->allocateMemory(allocateInfo);
+  expectResult("Buffer memory binding", vkBindBufferMemory(mContext->getDevice(), mBuffer, mMemory, 0));
+
+  void *mapped = nullptr;
+  expectResult("Mapping memory", vkMapMemory(mContext->getDevice(), mMemory, 0, createInfo.size, 0, &mapped));
+  mMapped = reinterpret_cast<const uint8_t *>(mapped);
+}
+
+VkDeviceSize Query::predicateOffset(uint32_t slot) const {
+  return SLOT_COUNT * mValueCount * sizeof(uint64_t) + slot * sizeof(uint32_t);
+}
+
+bool Query::read(uint64_t *values) const {
+  uint32_t latest = SLOT_COUNT;
+  for (uint32_t slot = 0; slot < SLOT_COUNT; ++slot) {
+    if (mFrames[slot] == 0 || mFrames[slot] >= mContext->getFrameIndex()) continue;
+    if (latest == SLOT_COUNT || mFrames[slot] > mFrames[latest]) latest = slot;
+  }
+  if (latest == SLOT_COUNT) return false;
+
+  std::memcpy(values, mMapped + latest * mValueCount * sizeof(uint64_t), mValueCount * sizeof(uint64_t));
+  return true;
+}
+
+} // namespace purrr::vulkan
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
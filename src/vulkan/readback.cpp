@@ -0,0 +1,233 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#include "purrr/exceptions.hpp"
+#include "purrr/vulkan/exceptions.hpp"
+
+#include "purrr/vulkan/readback.hpp"
+#include "purrr/vulkan/context.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace purrr::vulkan {
+
+ReadbackRing::ReadbackRing(Context *context, VkDeviceSize capacity)
+  : mContext(context), mCapacity(capacity) {
+  createBuffer();
+}
+
+ReadbackRing::~ReadbackRing() {
+  // Outstanding futures keep their data, they never touch the ring once it is gone
+  while (!mRequests.empty()) {
+    retire(*mRequests.front());
+    mRequests.pop_front();
+  }
+
+  destroyBuffer();
+}
+
+std::future<std::vector<uint8_t>> ReadbackRing::read(
+    VkDeviceSize size, VkDeviceSize alignment, const Record &record) {
+  // The copy is submitted right away, ahead of the open frame and the layouts it already moved images to
+  if (mContext->isFrameOpen()) throw InvalidUse("readback() cannot be called while a frame is recording");
+
+  auto request    = std::make_shared<Request>();
+  request->size   = size;
+  request->offset = allocate(size, alignment);
+
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fenceInfo.pNext = VK_NULL_HANDLE;
+  fenceInfo.flags = 0;
+
+  expectResult("Fence creation", vkCreateFence(mContext->getDevice(), &fenceInfo, VK_NULL_HANDLE, &request->fence));
+
+  VkCommandBufferAllocateInfo allocateInfo{};
+  allocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocateInfo.pNext              = VK_NULL_HANDLE;
+  allocateInfo.commandPool        = mContext->getCommandPool();
+  allocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocateInfo.commandBufferCount = 1;
+
+  expectResult(
+      "Command buffer allocation",
+      vkAllocateCommandBuffers(mContext->getDevice(), &allocateInfo, &request->commandBuffer));
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.pNext            = VK_NULL_HANDLE;
+  beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = VK_NULL_HANDLE;
+
+  expectResult("Command buffer begin", vkBeginCommandBuffer(request->commandBuffer, &beginInfo));
+
+  record(request->commandBuffer, mBuffer, request->offset);
+
+  // Makes the copy visible to the host once the fence signals
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.pNext               = VK_NULL_HANDLE;
+  barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer              = mBuffer;
+  barrier.offset              = request->offset;
+  barrier.size                = size;
+
+  vkCmdPipelineBarrier(
+      request->commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      0,
+      0,
+      VK_NULL_HANDLE,
+      1,
+      &barrier,
+      0,
+      VK_NULL_HANDLE);
+
+  expectResult("Command buffer end", vkEndCommandBuffer(request->commandBuffer));
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.pNext                = VK_NULL_HANDLE;
+  submitInfo.waitSemaphoreCount   = 0;
+  submitInfo.pWaitSemaphores      = VK_NULL_HANDLE;
+  submitInfo.pWaitDstStageMask    = VK_NULL_HANDLE;
+  submitInfo.commandBufferCount   = 1;
+  submitInfo.pCommandBuffers      = &request->commandBuffer;
+  submitInfo.signalSemaphoreCount = 0;
+  submitInfo.pSignalSemaphores    = VK_NULL_HANDLE;
+
+  expectResult("Queue submition", vkQueueSubmit(mContext->getQueue(), 1, &submitInfo, request->fence));
+  ++mContext->getCurrentStats().submits;
+
+  mRequests.push_back(request);
+
+  // Deferred, so reading the result from the thread owning the context never needs another thread to finish it
+  return std::async(std::launch::deferred, [this, request]() {
+    if (!request->done) complete(request);
+    return std::move(request->data);
+  });
+}
+
+void ReadbackRing::poll() {
+  while (!mRequests.empty()) {
+    Request &request = *mRequests.front();
+    if (vkGetFenceStatus(mContext->getDevice(), request.fence) != VK_SUCCESS) break;
+    retire(request);
+    mRequests.pop_front();
+  }
+}
+
+void ReadbackRing::createBuffer() {
+  VkBufferCreateInfo createInfo{};
+  createInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.pNext                 = VK_NULL_HANDLE;
+  createInfo.flags                 = 0;
+  createInfo.size                  = mCapacity;
+  createInfo.usage                 = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  createInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+  createInfo.queueFamilyIndexCount = 0;
+  createInfo.pQueueFamilyIndices   = VK_NULL_HANDLE;
+
+  expectResult("Buffer creation", vkCreateBuffer(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mBuffer));
+
+  VkMemoryRequirements memoryRequirements{};
+  vkGetBufferMemoryRequirements(mContext->getDevice(), mBuffer, &memoryRequirements);
+
+  // Cached memory makes reading on the host fast, uncached memory is read once per request anyway
+  VkMemoryPropertyFlags coherent = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  VkMemoryPropertyFlags cached   = coherent | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+  VkMemoryAllocateInfo allocateInfo{};
+  allocateInfo.sType          = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.pNext          = VK_NULL_HANDLE;
+  allocateInfo.allocationSize = memoryRequirements.size;
+  allocateInfo.memoryTypeIndex =
+      mContext->findMemoryType(memoryRequirements.memoryTypeBits, cached, coherent);
+
+  mMemory = mContext->allocateMemory(allocateInfo);
+  expectResult("Buffer memory binding", vkBindBufferMemory(mContext->getDevice(), mBuffer, mMemory, 0));
+
+  void *mapped = nullptr;
+  expectResult("Mapping memory", vkMapMemory(mContext->getDevice(), mMemory, 0, mCapacity, 0, &mapped));
+  mMapped = reinterpret_cast<const uint8_t *>(mapped);
+}
+
+void ReadbackRing::destroyBuffer() {
+  if (mMemory) {
+    vkUnmapMemory(mContext->getDevice(), mMemory);
+    mContext->freeMemory(mMemory);
+  }
+  if (mBuffer) vkDestroyBuffer(mContext->getDevice(), mBuffer, VK_NULL_HANDLE);
+
+  mMemory = VK_NULL_HANDLE;
+  mBuffer = VK_NULL_HANDLE;
+  mMapped = nullptr;
+}
+
+VkDeviceSize ReadbackRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+  if (size > mCapacity) { // Rare, large reads grow the ring once instead of failing
+    while (!mRequests.empty()) {
+      retire(*mRequests.front());
+      mRequests.pop_front();
+    }
+
+    destroyBuffer();
+    mCapacity = std::max(size, mCapacity * 2);
+    mHead     = 0;
+    createBuffer();
+  }
+
+  for (;;) {
+    VkDeviceSize offset = (mHead + alignment - 1) / alignment * alignment;
+    if (offset + size > mCapacity) offset = 0;
+
+    bool overlaps = false;
+    for (const std::shared_ptr<Request> &request : mRequests)
+      overlaps = overlaps || (offset < request->offset + request->size && request->offset < offset + size);
+
+    if (!overlaps) {
+      mHead = offset + size;
+      return offset;
+    }
+
+    // Only stalls when the ring is full of copies the GPU has not finished yet
+    retire(*mRequests.front());
+    mRequests.pop_front();
+  }
+}
+
+void ReadbackRing::retire(Request &request) {
+  if (request.done) return;
+
+  expectResult(
+      "Wait for fence",
+      vkWaitForFences(mContext->getDevice(), 1, &request.fence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+
+  request.data.resize(request.size);
+  memcpy(request.data.data(), mMapped + request.offset, request.size);
+
+  vkFreeCommandBuffers(mContext->getDevice(), mContext->getCommandPool(), 1, &request.commandBuffer);
+  vkDestroyFence(mContext->getDevice(), request.fence, VK_NULL_HANDLE);
+  request.commandBuffer = VK_NULL_HANDLE;
+  request.fence         = VK_NULL_HANDLE;
+  request.done          = true;
+}
+
+void ReadbackRing::complete(const std::shared_ptr<Request> &request) {
+  // Earlier requests finish first on the queue, retiring them keeps the ring in order
+  while (!mRequests.empty()) {
+    std::shared_ptr<Request> front = mRequests.front();
+    retire(*front);
+    mRequests.pop_front();
+    if (front == request) break;
+  }
+}
+
+} // namespace purrr::vulkan
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
@@ -0,0 +1,413 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#include "purrr/exceptions.hpp"
+
+#include "purrr/vulkan/exceptions.hpp"
+
+#include "purrr/vulkan/renderGraph.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace purrr::vulkan {
+
+RenderGraph::RenderGraph(Context *context)
+  : mContext(context) {}
+
+RenderGraph::~RenderGraph() {
+  for (Image *image : mImages) delete image;
+  for (VkDeviceMemory memory : mMemories) mContext->freeMemory(memory);
+}
+
+purrr::Image *RenderGraph::createImage(const ImageInfo &info) {
+  if (mCompiled) throw InvalidUse("Cannot create images after compile()");
+
+  // Lazily allocated memory gains nothing from aliasing
+  Image *image = new Image(mContext, info, info.usage.transient);
+  mImages.push_back(image);
+  return image;
+}
+
+void RenderGraph::addPass(const RenderGraphPassInfo &info) {
+  if (mCompiled) throw InvalidUse("Cannot add passes after compile()");
+
+  Pass pass{};
+  pass.info = info;
+
+  if (!info.renderTarget) throw InvalidUse("Render graph passes require a render target");
+  if (info.renderTarget->api() != Api::Vulkan) throw InvalidUse("Uncompatible render target object");
+  pass.renderTarget = reinterpret_cast<RenderTarget *>(info.renderTarget);
+  if (!pass.renderTarget->sameContext(mContext)) throw InvalidUse("Uncompatible render target object");
+
+  for (purrr::Image *image : info.sampledImages) {
+    if (image->api() != Api::Vulkan) throw InvalidUse("Uncompatible image object");
+    Image *vkImage = reinterpret_cast<Image *>(image);
+    if (!vkImage->getUsage().texture) throw InvalidUse("Uncompatible image object");
+    pass.sampledImages.push_back(vkImage);
+  }
+
+  for (purrr::Buffer *buffer : info.readBuffers) {
+    if (buffer->api() != Api::Vulkan) throw InvalidUse("Uncompatible buffer object");
+    pass.readBuffers.push_back(reinterpret_cast<Buffer *>(buffer));
+  }
+
+  for (purrr::Buffer *buffer : info.writeBuffers) {
+    if (buffer->api() != Api::Vulkan) throw InvalidUse("Uncompatible buffer object");
+    Buffer *vkBuffer = reinterpret_cast<Buffer *>(buffer);
+    if (vkBuffer->getType() != BufferType::Storage) throw InvalidUse("Uncompatible buffer object");
+    pass.writeBuffers.push_back(vkBuffer);
+  }
+
+  mPasses.push_back(std::move(pass));
+}
+
+void RenderGraph::addOutput(purrr::Image *image) {
+  if (mCompiled) throw InvalidUse("Cannot add outputs after compile()");
+  if (image->api() != Api::Vulkan) throw InvalidUse("Uncompatible image object");
+  mOutputs.push_back(reinterpret_cast<Image *>(image));
+}
+
+void RenderGraph::compile() {
+  if (mCompiled) throw InvalidUse("Render graph is already compiled");
+
+  sortPasses();
+  cullPasses();
+  aliasImages();
+
+  mCompiled = true;
+}
+
+void RenderGraph::execute() {
+  if (!mCompiled) throw InvalidUse("execute() called before compile()");
+
+  std::unordered_map<Buffer *, BufferState> buffers{};
+  for (size_t index : mOrder) recordPass(mPasses[index], &buffers);
+
+  std::vector<VkImageMemoryBarrier> barriers{};
+  VkPipelineStageFlags              srcStage = 0;
+  for (Image *image : mOutputs) {
+    if (!image->getUsage().texture) continue;
+
+    VkImageMemoryBarrier barrier{};
+    if (image->prepareTransition(
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            &barrier,
+            &srcStage))
+      barriers.push_back(barrier);
+  }
+
+  if (!barriers.empty())
+    vkCmdPipelineBarrier(
+        mContext->getCommandBuffer(),
+        srcStage,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0,
+        0,
+        VK_NULL_HANDLE,
+        0,
+        VK_NULL_HANDLE,
+        static_cast<uint32_t>(barriers.size()),
+        barriers.data());
+}
+
+bool RenderGraph::ownsImage(const void *image) const {
+  return std::find(mImages.begin(), mImages.end(), image) != mImages.end();
+}
+
+void RenderGraph::sortPasses() {
+  std::unordered_map<const void *, size_t>              lastWriters{};
+  std::unordered_map<const void *, std::vector<size_t>> readers{}; // Since the last write
+
+  auto addEdge = [this](size_t from, size_t to, bool producer) {
+    if (from == to) return;
+    mPasses[from].successors.push_back(to);
+    if (producer) mPasses[to].producers.push_back(from);
+  };
+
+  for (size_t i = 0; i < mPasses.size(); ++i) {
+    const Pass &pass = mPasses[i];
+
+    auto read = [&](const void *resource) {
+      auto writer = lastWriters.find(resource);
+      if (writer != lastWriters.end()) addEdge(writer->second, i, true);
+      readers[resource].push_back(i);
+    };
+
+    auto write = [&](const void *resource) {
+      auto writer = lastWriters.find(resource);
+      if (writer != lastWriters.end()) {
+        addEdge(writer->second, i, false);
+        for (size_t reader : readers[resource]) addEdge(reader, i, false);
+      } else if (ownsImage(resource)) {
+        // Graph images have no contents before their first write, earlier readers consume this one
+        for (size_t reader : readers[resource]) addEdge(i, reader, true);
+      } else {
+        for (size_t reader : readers[resource]) addEdge(reader, i, false);
+      }
+
+      readers[resource].clear();
+      lastWriters[resource] = i;
+    };
+
+    for (Image *image : pass.sampledImages) read(image);
+    for (Buffer *buffer : pass.readBuffers) read(buffer);
+
+    const std::vector<Image *> &attachments = pass.renderTarget->getImages();
+    const std::vector<LoadOp>  &loadOps     = pass.renderTarget->getLoadOps();
+    for (size_t j = 0; j < attachments.size(); ++j) {
+      if (loadOps[j] == LoadOp::Load) read(attachments[j]);
+      write(attachments[j]);
+    }
+
+    for (Buffer *buffer : pass.writeBuffers) write(buffer);
+  }
+
+  std::vector<size_t> inDegrees(mPasses.size(), 0);
+  for (const Pass &pass : mPasses) {
+    for (size_t successor : pass.successors) ++inDegrees[successor];
+  }
+
+  // Independent passes keep the order they were added in
+  std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready{};
+  for (size_t i = 0; i < mPasses.size(); ++i) {
+    if (inDegrees[i] == 0) ready.push(i);
+  }
+
+  mOrder.clear();
+  while (!ready.empty()) {
+    size_t index = ready.top();
+    ready.pop();
+    mOrder.push_back(index);
+
+    for (size_t successor : mPasses[index].successors) {
+      if (--inDegrees[successor] == 0) ready.push(successor);
+    }
+  }
+
+  if (mOrder.size() != mPasses.size()) throw InvalidUse("Render graph passes depend on each other in a cycle");
+}
+
+void RenderGraph::cullPasses() {
+  std::vector<bool>   alive(mPasses.size(), false);
+  std::vector<size_t> stack{};
+
+  // Writes to outputs, buffers and images outside the graph are visible after the frame
+  for (size_t i = 0; i < mPasses.size(); ++i) {
+    const Pass &pass = mPasses[i];
+
+    bool visible = !pass.writeBuffers.empty();
+    for (Image *image : pass.renderTarget->getImages()) {
+      visible = visible || !ownsImage(image) ||
+                std::find(mOutputs.begin(), mOutputs.end(), image) != mOutputs.end();
+    }
+
+    if (!visible) continue;
+    alive[i] = true;
+    stack.push_back(i);
+  }
+
+  while (!stack.empty()) {
+    size_t index = stack.back();
+    stack.pop_back();
+
+    for (size_t producer : mPasses[index].producers) {
+      if (alive[producer]) continue;
+      alive[producer] = true;
+      stack.push_back(producer);
+    }
+  }
+
+  mOrder.erase(
+      std::remove_if(mOrder.begin(), mOrder.end(), [&alive](size_t index) { return !alive[index]; }),
+      mOrder.end());
+}
+
+void RenderGraph::aliasImages() {
+  struct Lifetime {
+    size_t first, last;
+  };
+
+  std::unordered_map<Image *, Lifetime> lifetimes{};
+  std::vector<Image *>                  images{}; // In order of first use
+
+  for (size_t position = 0; position < mOrder.size(); ++position) {
+    const Pass &pass = mPasses[mOrder[position]];
+
+    auto use = [&](Image *image) {
+      if (!ownsImage(image) || image->getImageView() != VK_NULL_HANDLE) return;
+      auto [lifetime, inserted] = lifetimes.try_emplace(image, Lifetime{ position, position });
+      if (inserted) images.push_back(image);
+      lifetime->second.last = position;
+    };
+
+    for (Image *image : pass.sampledImages) use(image);
+    for (Image *image : pass.renderTarget->getImages()) use(image);
+  }
+
+  // Outputs are read after the graph, nothing may take over their memory
+  for (Image *image : mOutputs) {
+    auto lifetime = lifetimes.find(image);
+    if (lifetime != lifetimes.end()) lifetime->second.last = mOrder.size();
+  }
+
+  struct Slot {
+    Image       *image;
+    size_t       last;
+    VkDeviceSize size;
+    uint32_t     typeBits;
+  };
+
+  std::vector<Slot>                   slots{};
+  std::unordered_map<Image *, size_t> slotIndices{};
+
+  for (Image *image : images) {
+    const Lifetime       &lifetime     = lifetimes[image];
+    VkMemoryRequirements requirements = image->getMemoryRequirements();
+
+    mPasses[mOrder[lifetime.first]].firstUses.push_back(image);
+
+    auto slot = std::find_if(slots.begin(), slots.end(), [&](const Slot &slot) {
+      return slot.last < lifetime.first && (slot.typeBits & requirements.memoryTypeBits) != 0;
+    });
+
+    if (slot == slots.end()) {
+      slotIndices[image] = slots.size();
+      slots.push_back({ image, lifetime.last, requirements.size, requirements.memoryTypeBits });
+      continue;
+    }
+
+    mPrevious[image]   = slot->image;
+    slotIndices[image] = static_cast<size_t>(slot - slots.begin());
+    slot->image        = image;
+    slot->last         = lifetime.last;
+    slot->size         = std::max(slot->size, requirements.size);
+    slot->typeBits    &= requirements.memoryTypeBits;
+  }
+
+  // Every slot starts at offset zero of its own allocation, which satisfies any alignment
+  for (const Slot &slot : slots) {
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext           = VK_NULL_HANDLE;
+    allocateInfo.allocationSize  = slot.size;
+    allocateInfo.memoryTypeIndex = mContext->findMemoryType(slot.typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    mMemories.push_back(mContext->allocateMemory(allocateInfo));
+  }
+
+  for (Image *image : images) image->bindMemory(mMemories[slotIndices[image]], 0);
+}
+
+void RenderGraph::recordPass(const Pass &pass, std::unordered_map<Buffer *, BufferState> *buffers) {
+  // Graph images start every frame undefined, an image sharing memory waits for the previous user
+  for (Image *image : pass.firstUses) {
+    auto previous = mPrevious.find(image);
+    if (previous == mPrevious.end())
+      image->assumeLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    else
+      image->assumeLayout(VK_IMAGE_LAYOUT_UNDEFINED, previous->second->getStage(), previous->second->getAccess());
+  }
+
+  std::vector<VkImageMemoryBarrier> imageBarriers{};
+  VkPipelineStageFlags              srcStage = 0;
+  VkPipelineStageFlags              dstStage = 0;
+
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.pNext         = VK_NULL_HANDLE;
+  memoryBarrier.srcAccessMask = 0;
+  memoryBarrier.dstAccessMask = 0;
+
+  for (Image *image : pass.sampledImages) {
+    VkImageMemoryBarrier barrier{};
+    if (!image->prepareTransition(
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            &barrier,
+            &srcStage))
+      continue;
+
+    imageBarriers.push_back(barrier);
+    dstStage |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  }
+
+  size_t sampledBarrierCount = imageBarriers.size();
+  pass.renderTarget->prepareAttachments(&imageBarriers, &srcStage);
+  if (imageBarriers.size() != sampledBarrierCount) dstStage |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+  for (Buffer *buffer : pass.readBuffers) {
+    BufferState read  = readState(buffer->getType());
+    auto        state = buffers->find(buffer);
+    if (state == buffers->end()) {
+      buffers->emplace(buffer, read);
+    } else if (state->second.access & VK_ACCESS_SHADER_WRITE_BIT) {
+      srcStage                    |= state->second.stage;
+      dstStage                    |= read.stage;
+      memoryBarrier.srcAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+      memoryBarrier.dstAccessMask |= read.access;
+      state->second                = read;
+    } else {
+      state->second.stage  |= read.stage;
+      state->second.access |= read.access;
+    }
+  }
+
+  for (Buffer *buffer : pass.writeBuffers) {
+    BufferState write = { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_SHADER_WRITE_BIT };
+    auto        state = buffers->find(buffer);
+    if (state != buffers->end()) { // Reads only need to finish, writes need to be visible
+      srcStage |= state->second.stage;
+      dstStage |= write.stage;
+      if (state->second.access & VK_ACCESS_SHADER_WRITE_BIT) {
+        memoryBarrier.srcAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+      }
+    }
+
+    (*buffers)[buffer] = write;
+  }
+
+  if (dstStage != 0)
+    vkCmdPipelineBarrier(
+        mContext->getCommandBuffer(),
+        srcStage,
+        dstStage,
+        0,
+        memoryBarrier.srcAccessMask != 0 ? 1 : 0,
+        &memoryBarrier,
+        0,
+        VK_NULL_HANDLE,
+        static_cast<uint32_t>(imageBarriers.size()),
+        imageBarriers.data());
+
+  RecordClear clear{ pass.info.clearValues };
+  if (pass.info.name) mContext->beginScope(pass.info.name);
+  if (!mContext->record(pass.renderTarget, clear)) throw InvalidUse("Render graph pass could not be recorded");
+  if (pass.info.record) pass.info.record(mContext);
+  mContext->end();
+  if (pass.info.name) mContext->endScope();
+}
+
+RenderGraph::BufferState RenderGraph::readState(BufferType type) {
+  switch (type) {
+  case BufferType::Vertex: return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT };
+  case BufferType::Index: return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT };
+  case BufferType::Uniform:
+    return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT };
+  case BufferType::Storage:
+    return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+  }
+
+  throw Unreachable();
+}
+
+} // namespace purrr::vulkan
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
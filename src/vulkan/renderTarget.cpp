@@ -8,12 +8,34 @@
 #include "purrr/vulkan/program.hpp"
 #include "purrr/vulkan/format.hpp"
 
+#include <algorithm>
 #include <vector>
 
 namespace purrr::vulkan {
 
+VkAttachmentLoadOp vkLoadOp(LoadOp loadOp) {
+  switch (loadOp) {
+  case LoadOp::Load: return VK_ATTACHMENT_LOAD_OP_LOAD;
+  case LoadOp::Clear: return VK_ATTACHMENT_LOAD_OP_CLEAR;
+  case LoadOp::DontCare: return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  }
+
+  throw Unreachable();
+}
+
+VkAttachmentStoreOp vkStoreOp(StoreOp storeOp) {
+  switch (storeOp) {
+  case StoreOp::Store: return VK_ATTACHMENT_STORE_OP_STORE;
+  case StoreOp::DontCare: return VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  }
+
+  throw Unreachable();
+}
+
 RenderTarget::RenderTarget(Context *context, const RenderTargetInfo &info)
-  : mContext(context) {
+  : mWidth(static_cast<uint32_t>(info.width)), mHeight(static_cast<uint32_t>(info.height)), mContext(context) {
+  if (info.name) mName = info.name;
+
   mImages.reserve(info.imageCount);
   for (size_t i = 0; i < info.imageCount; ++i) {
     purrr::Image *image = info.images[i];
@@ -21,10 +43,31 @@ RenderTarget::RenderTarget(Context *context, const RenderTargetInfo &info)
     Image *vkImage = reinterpret_cast<Image *>(image);
     if (!vkImage->getUsage().renderTarget) throw InvalidUse("Uncompatible image object");
     mImages.push_back(vkImage);
+
+    LoadOp  loadOp  = info.loadOps ? info.loadOps[i] : LoadOp::Clear;
+    StoreOp storeOp = info.storeOps ? info.storeOps[i] : StoreOp::Store;
+    mLoadOps.push_back(loadOp);
+    mStoreOps.push_back(storeOp);
+
+    // Transient images have no backing memory to load from or store to
+    if (vkImage->getUsage().transient && (loadOp == LoadOp::Load || storeOp == StoreOp::Store))
+      throw InvalidUse("Transient images can be neither loaded nor stored");
+
+    if (loadOp == LoadOp::Clear) mClearValueCount = static_cast<uint32_t>(i + 1);
+  }
+
+  // Dynamic rendering has no notion of subpasses, those targets keep their render pass
+  if (context->usesDynamicRendering() && !info.subpasses) {
+    mColorAttachmentCounts = { static_cast<uint32_t>(info.imageCount) };
+    return;
   }
 
   createRenderPass(info);
-  createFramebuffer(info);
+
+  // Images owned by a render graph get their memory when the graph is compiled
+  bool bound = true;
+  for (Image *image : mImages) bound = bound && image->getImageView() != VK_NULL_HANDLE;
+  if (bound) createFramebuffer();
 }
 
 RenderTarget::~RenderTarget() {
@@ -38,43 +81,172 @@ purrr::Program *RenderTarget::createProgram(const ProgramInfo &info) {
 
 void RenderTarget::createRenderPass(const RenderTargetInfo &info) {
   std::vector<VkAttachmentDescription> attachments(info.imageCount);
-  std::vector<VkAttachmentReference>   attachmentRefs(info.imageCount);
+
+  VkPipelineStageFlags srcStage  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  VkAccessFlags        srcAccess = 0;
+  VkAccessFlags        dstAccess = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
   for (size_t i = 0; i < info.imageCount; ++i) {
+    LoadOp  loadOp  = info.loadOps ? info.loadOps[i] : LoadOp::Clear;
+    StoreOp storeOp = info.storeOps ? info.storeOps[i] : StoreOp::Store;
+
+    if (loadOp == LoadOp::Load) { // Wait for the previous pass writing the loaded contents
+      srcStage   = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      srcAccess  = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+      dstAccess |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+    }
+
     attachments[i].flags          = 0;
     attachments[i].format         = vkFormat(mImages[i]->getFormat());
     attachments[i].samples        = VK_SAMPLE_COUNT_1_BIT;
-    attachments[i].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachments[i].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[i].loadOp         = vkLoadOp(loadOp);
+    attachments[i].storeOp        = vkStoreOp(storeOp);
     attachments[i].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachments[i].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[i].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[i].initialLayout =
+        (loadOp == LoadOp::Load) ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[i].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  }
+
+  // Without subpass descriptions every image is written by a single subpass
+  std::vector<uint32_t> everyAttachment(info.imageCount);
+  for (size_t i = 0; i < info.imageCount; ++i) everyAttachment[i] = static_cast<uint32_t>(i);
+  SubpassInfo defaultSubpass = { everyAttachment.data(), everyAttachment.size() };
+
+  const SubpassInfo *subpassInfos = info.subpasses ? info.subpasses : &defaultSubpass;
+  size_t             subpassCount = info.subpasses ? info.subpassCount : 1;
+  if (subpassCount == 0) throw InvalidUse("Render targets require at least one subpass");
+
+  std::vector<VkSubpassDependency> dependencies{};
+
+  VkSubpassDependency external{};
+  external.srcSubpass      = VK_SUBPASS_EXTERNAL;
+  external.dstSubpass      = 0;
+  external.srcStageMask    = srcStage;
+  external.dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  external.srcAccessMask   = srcAccess;
+  external.dstAccessMask   = dstAccess;
+  external.dependencyFlags = 0;
+  dependencies.push_back(external);
+
+  auto addDependency = [&dependencies](
+                           uint32_t             src,
+                           uint32_t             dst,
+                           VkPipelineStageFlags srcStage,
+                           VkAccessFlags        srcAccess,
+                           VkPipelineStageFlags dstStage,
+                           VkAccessFlags        dstAccess) {
+    for (VkSubpassDependency &dependency : dependencies) {
+      if (dependency.srcSubpass != src || dependency.dstSubpass != dst) continue;
+      dependency.srcStageMask  |= srcStage;
+      dependency.srcAccessMask |= srcAccess;
+      dependency.dstStageMask  |= dstStage;
+      dependency.dstAccessMask |= dstAccess;
+      return;
+    }
+
+    // Subpasses only touch their own pixels of an attachment, letting tilers keep it in tile memory
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass      = src;
+    dependency.dstSubpass      = dst;
+    dependency.srcStageMask    = srcStage;
+    dependency.dstStageMask    = dstStage;
+    dependency.srcAccessMask   = srcAccess;
+    dependency.dstAccessMask   = dstAccess;
+    dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    dependencies.push_back(dependency);
+  };
+
+  std::vector<std::vector<VkAttachmentReference>> colorRefs(subpassCount);
+  std::vector<std::vector<VkAttachmentReference>> inputRefs(subpassCount);
+  std::vector<std::vector<bool>>                  used(subpassCount, std::vector<bool>(info.imageCount, false));
+  std::vector<uint32_t>                           lastWriters(info.imageCount, VK_SUBPASS_EXTERNAL);
+  std::vector<std::vector<uint32_t>>              readers(info.imageCount); // Since the last write
+
+  for (uint32_t i = 0; i < subpassCount; ++i) {
+    const SubpassInfo &subpassInfo = subpassInfos[i];
 
-    attachmentRefs[i].attachment = static_cast<uint32_t>(i);
-    attachmentRefs[i].layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    for (size_t j = 0; j < subpassInfo.inputAttachmentCount; ++j) {
+      uint32_t attachment = subpassInfo.inputAttachments[j];
+      if (attachment >= info.imageCount) throw InvalidUse("Subpass attachment out of range");
+      if (!mImages[attachment]->getUsage().inputAttachment) throw InvalidUse("Uncompatible image object");
+
+      inputRefs[i].push_back({ attachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+      used[i][attachment] = true;
+      readers[attachment].push_back(i);
+
+      if (lastWriters[attachment] != VK_SUBPASS_EXTERNAL)
+        addDependency(
+            lastWriters[attachment],
+            i,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_INPUT_ATTACHMENT_READ_BIT);
+    }
+
+    for (size_t j = 0; j < subpassInfo.colorAttachmentCount; ++j) {
+      uint32_t attachment = subpassInfo.colorAttachments[j];
+      if (attachment >= info.imageCount) throw InvalidUse("Subpass attachment out of range");
+
+      colorRefs[i].push_back({ attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+      used[i][attachment] = true;
+
+      if (lastWriters[attachment] != VK_SUBPASS_EXTERNAL)
+        addDependency(
+            lastWriters[attachment],
+            i,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+
+      for (uint32_t reader : readers[attachment]) {
+        if (reader != i)
+          addDependency(
+              reader,
+              i,
+              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+              0,
+              VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+              VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+      }
+
+      readers[attachment].clear();
+      lastWriters[attachment] = i;
+    }
+
+    mColorAttachmentCounts.push_back(static_cast<uint32_t>(colorRefs[i].size()));
+  }
+
+  // Attachments used before and after a subpass that ignores them must be preserved through it
+  std::vector<std::vector<uint32_t>> preserveRefs(subpassCount);
+  for (uint32_t attachment = 0; attachment < info.imageCount; ++attachment) {
+    size_t first = subpassCount, last = 0;
+    for (size_t i = 0; i < subpassCount; ++i) {
+      if (!used[i][attachment]) continue;
+      first = std::min(first, i);
+      last  = i;
+    }
+
+    for (size_t i = first + 1; i < last; ++i) {
+      if (!used[i][attachment]) preserveRefs[i].push_back(attachment);
+    }
   }
 
-  VkSubpassDescription subpass{};
-  subpass.flags                   = 0;
-  subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-  subpass.inputAttachmentCount    = 0;
-  subpass.pInputAttachments       = VK_NULL_HANDLE;
-  subpass.colorAttachmentCount    = static_cast<uint32_t>(attachmentRefs.size());
-  subpass.pColorAttachments       = attachmentRefs.data();
-  subpass.pResolveAttachments     = VK_NULL_HANDLE;
-  subpass.pDepthStencilAttachment = VK_NULL_HANDLE;
-  subpass.preserveAttachmentCount = 0;
-  subpass.pPreserveAttachments    = VK_NULL_HANDLE;
-
-  VkSubpassDependency dependency{};
-  dependency.srcSubpass      = VK_SUBPASS_EXTERNAL;
-  dependency.dstSubpass      = 0;
-  dependency.srcStageMask    = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-  dependency.dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependency.srcAccessMask   = 0;
-  dependency.dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-  dependency.dependencyFlags = 0;
+  std::vector<VkSubpassDescription> subpasses(subpassCount);
+  for (size_t i = 0; i < subpassCount; ++i) {
+    subpasses[i].flags                   = 0;
+    subpasses[i].pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[i].inputAttachmentCount    = static_cast<uint32_t>(inputRefs[i].size());
+    subpasses[i].pInputAttachments       = inputRefs[i].data();
+    subpasses[i].colorAttachmentCount    = static_cast<uint32_t>(colorRefs[i].size());
+    subpasses[i].pColorAttachments       = colorRefs[i].data();
+    subpasses[i].pResolveAttachments     = VK_NULL_HANDLE;
+    subpasses[i].pDepthStencilAttachment = VK_NULL_HANDLE;
+    subpasses[i].preserveAttachmentCount = static_cast<uint32_t>(preserveRefs[i].size());
+    subpasses[i].pPreserveAttachments    = preserveRefs[i].data();
+  }
 
   VkRenderPassCreateInfo createInfo{};
   createInfo.sType           = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -82,20 +254,62 @@ void RenderTarget::createRenderPass(const RenderTargetInfo &info) {
   createInfo.flags           = 0;
   createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
   createInfo.pAttachments    = attachments.data();
-  createInfo.subpassCount    = 1;
-  createInfo.pSubpasses      = &subpass;
-  createInfo.dependencyCount = 1;
-  createInfo.pDependencies   = &dependency;
+  createInfo.subpassCount    = static_cast<uint32_t>(subpasses.size());
+  createInfo.pSubpasses      = subpasses.data();
+  createInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+  createInfo.pDependencies   = dependencies.data();
 
   expectResult(
       "Render pass creation",
       vkCreateRenderPass(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mRenderPass));
+  mContext->setObjectName(VK_OBJECT_TYPE_RENDER_PASS, reinterpret_cast<uint64_t>(mRenderPass), info.name);
 }
 
-void RenderTarget::createFramebuffer(const RenderTargetInfo &info) {
-  std::vector<VkImageView> attachments(info.imageCount);
-  for (size_t i = 0; i < info.imageCount; ++i) {
-    attachments[i] = mImages[i]->getImageView();
+uint32_t RenderTarget::getSubpassCount() const {
+  return static_cast<uint32_t>(mColorAttachmentCounts.size());
+}
+
+uint32_t RenderTarget::getColorAttachmentCount(uint32_t subpass) const {
+  return mColorAttachmentCounts[subpass];
+}
+
+std::vector<VkFormat> RenderTarget::getColorFormats() const {
+  std::vector<VkFormat> formats(mImages.size());
+  for (size_t i = 0; i < mImages.size(); ++i) formats[i] = vkFormat(mImages[i]->getFormat());
+  return formats;
+}
+
+bool RenderTarget::renderPassCompatible(const IRenderTarget *other) const {
+  if (other == this) return true;
+
+  // Single subpass render passes only differ in their attachments and the dependency derived from the load ops
+  const RenderTarget *target = dynamic_cast<const RenderTarget *>(other);
+  if (!target || !mRenderPass || !target->mRenderPass) return false;
+  if (mColorAttachmentCounts.size() != 1 || target->mColorAttachmentCounts.size() != 1) return false;
+  return mLoadOps == target->mLoadOps && getColorFormats() == target->getColorFormats();
+}
+
+void RenderTarget::prepareAttachments(std::vector<VkImageMemoryBarrier> *barriers, VkPipelineStageFlags *srcStage) {
+  for (size_t i = 0; i < mImages.size(); ++i) {
+    VkAccessFlags access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    if (mLoadOps[i] == LoadOp::Load) access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+
+    VkImageMemoryBarrier barrier{};
+    if (mImages[i]->prepareTransition(
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            access,
+            &barrier,
+            srcStage))
+      barriers->push_back(barrier);
+  }
+}
+
+void RenderTarget::createFramebuffer() {
+  std::vector<VkImageView> attachments(mImages.size());
+  for (size_t i = 0; i < mImages.size(); ++i) {
+    attachments[i] = mImages[i]->getAttachmentView();
+    if (attachments[i] == VK_NULL_HANDLE) throw InvalidUse("Render target images have no memory bound");
   }
 
   VkFramebufferCreateInfo createInfo{};
@@ -112,6 +326,8 @@ void RenderTarget::createFramebuffer(const RenderTargetInfo &info) {
   expectResult(
       "Framebuffer creation",
       vkCreateFramebuffer(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mFramebuffer));
+  if (!mName.empty())
+    mContext->setObjectName(VK_OBJECT_TYPE_FRAMEBUFFER, reinterpret_cast<uint64_t>(mFramebuffer), mName.c_str());
 }
 
 } // namespace purrr::vulkan
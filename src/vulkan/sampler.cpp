@@ -46,7 +46,7 @@ Sampler::Sampler(Context *context, const SamplerInfo &info)
   createInfo.compareEnable           = VK_FALSE;
   createInfo.compareOp               = VK_COMPARE_OP_NEVER;
   createInfo.minLod                  = 0.0f;
-  createInfo.maxLod                  = 1.0f;
+  createInfo.maxLod                  = VK_LOD_CLAMP_NONE;
   createInfo.borderColor             = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
   createInfo.unnormalizedCoordinates = VK_FALSE;
 
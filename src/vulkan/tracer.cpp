@@ -0,0 +1,146 @@
+#ifdef _PURRR_BACKEND_VULKAN
+
+#include "purrr/vulkan/exceptions.hpp"
+
+#include "purrr/vulkan/tracer.hpp"
+#include "purrr/vulkan/context.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+namespace purrr::vulkan {
+
+static void writeString(std::ostream &stream, const std::string &string) {
+  stream << '"';
+  for (char c : string) {
+    if (c == '"' || c == '\\') {
+      stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      stream << escaped;
+    } else {
+      stream << c;
+    }
+  }
+  stream << '"';
+}
+
+Tracer::Tracer(Context *context)
+  : mContext(context), mStart(context->getTime()) {
+  if (mContext->usesCalibratedTimestamps()) loadCalibration();
+}
+
+double Tracer::now() const {
+  return mContext->getTime();
+}
+
+void Tracer::addCpuSpan(const char *name, double start, double end) {
+  mEvents.push_back({ name, 0, start, end - start });
+}
+
+void Tracer::addSubmit(uint64_t frameIndex, double time) {
+  mSubmits[frameIndex % mSubmits.size()] = { frameIndex, time };
+}
+
+void Tracer::addGpuFrame(const GpuProfiler &profiler) {
+  const Submit &submit = mSubmits[profiler.getTimingsFrame() % mSubmits.size()];
+  if (submit.frame != profiler.getTimingsFrame() || submit.frame == 0) return;
+
+  const std::vector<GpuTiming> &timings    = profiler.getTimings();
+  const std::vector<uint64_t>  &timestamps = profiler.getTimestamps();
+  if (timestamps.empty()) return;
+
+  // Without calibration the first scope is placed at the submit of its frame
+  uint64_t ticks = timestamps.front();
+  double   time  = submit.time;
+  calibrate(ticks, time);
+
+  double secondsPerTick = profiler.getPeriod() * 1e-9;
+  for (size_t i = 0; i < timings.size(); ++i) {
+    uint64_t begin    = timestamps[i * 2];
+    uint64_t end      = timestamps[i * 2 + 1];
+    double   start    = time - static_cast<double>((ticks - begin) & profiler.getMask()) * secondsPerTick;
+    double   duration = static_cast<double>((end - begin) & profiler.getMask()) * secondsPerTick;
+    mEvents.push_back({ timings[i].name, 1, start, duration });
+  }
+}
+
+void Tracer::write(std::ostream &stream) const {
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+  stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+  stream << std::fixed << std::setprecision(3);
+  for (const Event &event : mEvents) {
+    stream << ",\n{\"name\":";
+    writeString(stream, event.name);
+    stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.track << ",\"ts\":" << (event.start - mStart) * 1e6
+           << ",\"dur\":" << std::max(event.duration, 0.0) * 1e6 << "}";
+  }
+
+  stream << "\n]}\n";
+}
+
+void Tracer::loadCalibration() {
+  auto getTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+      vkGetInstanceProcAddr(mContext->getInstance(), "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+  if (!getTimeDomains) return;
+
+  uint32_t count = 0;
+  getTimeDomains(mContext->getPhysicalDevice(), &count, VK_NULL_HANDLE);
+  std::vector<VkTimeDomainEXT> domains(count);
+  getTimeDomains(mContext->getPhysicalDevice(), &count, domains.data());
+
+  auto supported = [&domains](VkTimeDomainEXT domain) {
+    return std::find(domains.begin(), domains.end(), domain) != domains.end();
+  };
+  if (!supported(VK_TIME_DOMAIN_DEVICE_EXT)) return;
+
+#ifdef _PURRR_PLATFORM_LINUX
+  mHostClock = supported(VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT);
+#endif
+
+  mGetCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+      vkGetDeviceProcAddr(mContext->getDevice(), "vkGetCalibratedTimestampsEXT"));
+}
+
+bool Tracer::calibrate(uint64_t &ticks, double &time) const {
+  if (!mGetCalibratedTimestamps) return false;
+
+  std::array<VkCalibratedTimestampInfoEXT, 2> infos{};
+  infos[0].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[0].pNext      = VK_NULL_HANDLE;
+  infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+  infos[1].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[1].pNext      = VK_NULL_HANDLE;
+  infos[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+
+  // Other host clocks are bracketed by getTime(), which is precise to a few microseconds
+  std::array<uint64_t, 2> timestamps{};
+  uint64_t                deviation = 0;
+  double                  before    = now();
+  expectResult(
+      "Timestamp calibration",
+      mGetCalibratedTimestamps(
+          mContext->getDevice(), mHostClock ? 2 : 1, infos.data(), timestamps.data(), &deviation));
+  double after = now();
+
+  ticks = timestamps[0];
+  time  = mHostClock ? static_cast<double>(timestamps[1]) * 1e-9 : (before + after) * 0.5;
+  return true;
+}
+
+TraceSpan::TraceSpan(Tracer *tracer, const char *name)
+  : mTracer(tracer), mName(name) {
+  if (mTracer) mStart = mTracer->now();
+}
+
+TraceSpan::~TraceSpan() {
+  if (mTracer) mTracer->addCpuSpan(mName, mStart, mTracer->now());
+}
+
+} // namespace purrr::vulkan
+
+#endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
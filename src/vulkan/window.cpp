@@ -1,5 +1,7 @@
 #ifdef _PURRR_BACKEND_VULKAN
 
+#include "purrr/exceptions.hpp"
+
 #include "purrr/vulkan/exceptions.hpp"
 
 #include "purrr/vulkan/window.hpp"
@@ -13,15 +15,28 @@
 
 namespace purrr::vulkan {
 
+VkPresentModeKHR vkPresentMode(PresentMode mode) {
+  switch (mode) {
+  case PresentMode::Fifo: return VK_PRESENT_MODE_FIFO_KHR;
+  case PresentMode::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+  case PresentMode::Mailbox: return VK_PRESENT_MODE_MAILBOX_KHR;
+  case PresentMode::Immediate: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+  }
+
+  throw Unreachable();
+}
+
 Window::Window(Context *context, const WindowInfo &info)
-  : purrr::platform::Window(context, info), mContext(context) {
+  : purrr::platform::Window(context, info), mContext(context), mMinImageCount(info.imageCount) {
   expectResult("Surface creation", createSurface(context->getInstance(), &mSurface));
   chooseSurfaceFormat();
-  createRenderPass();
+  choosePresentMode(info.presentMode);
+  if (!context->usesDynamicRendering()) createRenderPass();
   createSwapchain();
 }
 
 Window::~Window() {
+  destroyRetired(true);
   cleanupSwapchain();
 
   if (mRenderPass) vkDestroyRenderPass(mContext->getDevice(), mRenderPass, VK_NULL_HANDLE);
@@ -55,6 +70,36 @@ void Window::chooseSurfaceFormat() {
   throw std::runtime_error("Failed to choose a surface format");
 }
 
+void Window::choosePresentMode(PresentMode requested) {
+  uint32_t count = 0;
+  expectResult(
+      "Surface present modes query",
+      vkGetPhysicalDeviceSurfacePresentModesKHR(mContext->getPhysicalDevice(), mSurface, &count, VK_NULL_HANDLE));
+
+  std::vector<VkPresentModeKHR> availableModes(count);
+  expectResult(
+      "Surface present modes query",
+      vkGetPhysicalDeviceSurfacePresentModesKHR(
+          mContext->getPhysicalDevice(),
+          mSurface,
+          &count,
+          availableModes.data()));
+
+  // Modes that do not wait for the vertical blank are preferred over each other before falling back to FIFO
+  std::vector<PresentMode> candidates = { requested };
+  if (requested == PresentMode::Mailbox) candidates.push_back(PresentMode::Immediate);
+  if (requested == PresentMode::Immediate) candidates.push_back(PresentMode::Mailbox);
+
+  for (PresentMode mode : candidates) {
+    if (std::find(availableModes.begin(), availableModes.end(), vkPresentMode(mode)) == availableModes.end()) continue;
+    mPresentMode = mode;
+    return;
+  }
+
+  // Every surface supports FIFO
+  mPresentMode = PresentMode::Fifo;
+}
+
 void Window::createRenderPass() {
   VkAttachmentDescription attachment{};
   attachment.flags          = 0;
@@ -108,26 +153,28 @@ void Window::createRenderPass() {
       vkCreateRenderPass(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mRenderPass));
 }
 
-void Window::createSwapchain() {
+void Window::createSwapchain(VkSwapchainKHR oldSwapchain) {
   VkSurfaceCapabilitiesKHR capabilities{};
   expectResult(
       "Surface capabilities query",
       vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mContext->getPhysicalDevice(), mSurface, &capabilities));
 
+  VkExtent2D extent{};
   if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-    mSwapchainExtent.width  = capabilities.currentExtent.width;
-    mSwapchainExtent.height = capabilities.currentExtent.height;
+    extent.width  = capabilities.currentExtent.width;
+    extent.height = capabilities.currentExtent.height;
   } else {
     auto [width, height] = getSize();
-    mSwapchainExtent.width =
+    extent.width =
         std::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-    mSwapchainExtent.height = std::clamp(
+    extent.height = std::clamp(
         static_cast<uint32_t>(height),
         capabilities.minImageExtent.height,
         capabilities.maxImageExtent.height);
   }
 
-  uint32_t minImageCount = capabilities.minImageCount + 1;
+  uint32_t minImageCount = mMinImageCount ? std::max(mMinImageCount, capabilities.minImageCount)
+                                         : capabilities.minImageCount + 1;
   if (capabilities.maxImageCount > 0 && minImageCount > capabilities.maxImageCount)
     minImageCount = capabilities.maxImageCount;
 
@@ -139,7 +186,7 @@ void Window::createSwapchain() {
   createInfo.minImageCount         = minImageCount;
   createInfo.imageFormat           = mFormat;
   createInfo.imageColorSpace       = mColorSpace;
-  createInfo.imageExtent           = mSwapchainExtent;
+  createInfo.imageExtent           = extent;
   createInfo.imageArrayLayers      = 1;
   createInfo.imageUsage            = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
   createInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
@@ -147,13 +194,19 @@ void Window::createSwapchain() {
   createInfo.pQueueFamilyIndices   = VK_NULL_HANDLE;
   createInfo.preTransform          = capabilities.currentTransform;
   createInfo.compositeAlpha        = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-  createInfo.presentMode           = VK_PRESENT_MODE_FIFO_KHR;
+  createInfo.presentMode           = vkPresentMode(mPresentMode);
   createInfo.clipped               = VK_TRUE;
-  createInfo.oldSwapchain          = VK_NULL_HANDLE;
+  createInfo.oldSwapchain          = oldSwapchain;
 
+  VkSwapchainKHR swapchain = VK_NULL_HANDLE;
   expectResult(
       "Swapchain creation",
-      vkCreateSwapchainKHR(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mSwapchain));
+      vkCreateSwapchainKHR(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &swapchain));
+
+  // Only retired once its replacement exists, a failed creation keeps the window on the old swapchain
+  if (oldSwapchain != VK_NULL_HANDLE) retireSwapchain();
+  mSwapchain       = swapchain;
+  mSwapchainExtent = extent;
 
   expectResult(
       "Swapchain images query",
@@ -164,7 +217,7 @@ void Window::createSwapchain() {
       vkGetSwapchainImagesKHR(mContext->getDevice(), mSwapchain, &mImageCount, mImages.data()));
 
   createImageViews();
-  createFramebuffers();
+  if (mRenderPass) createFramebuffers();
   createSemaphores();
 }
 
@@ -222,9 +275,11 @@ void Window::createSemaphores() {
   createInfo.pNext = VK_NULL_HANDLE;
   createInfo.flags = 0;
 
-  expectResult(
-      "Semaphore creation",
-      vkCreateSemaphore(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &mImageSemaphore));
+  for (VkSemaphore &semaphore : mImageSemaphores) {
+    expectResult(
+        "Semaphore creation",
+        vkCreateSemaphore(mContext->getDevice(), &createInfo, VK_NULL_HANDLE, &semaphore));
+  }
 
   mSubmitSemaphores.resize(mImageCount);
   for (uint32_t i = 0; i < mImageCount; ++i) {
@@ -235,7 +290,10 @@ void Window::createSemaphores() {
 }
 
 void Window::cleanupSwapchain() {
-  if (mImageSemaphore) vkDestroySemaphore(mContext->getDevice(), mImageSemaphore, VK_NULL_HANDLE);
+  for (VkSemaphore &semaphore : mImageSemaphores) {
+    if (semaphore) vkDestroySemaphore(mContext->getDevice(), semaphore, VK_NULL_HANDLE);
+    semaphore = VK_NULL_HANDLE;
+  }
 
   for (VkSemaphore semaphore : mSubmitSemaphores) {
     vkDestroySemaphore(mContext->getDevice(), semaphore, VK_NULL_HANDLE);
@@ -254,19 +312,59 @@ void Window::cleanupSwapchain() {
 
   mImages.clear();
 
-  if (mSwapchain) vkDestroySwapchainKHR(mContext->getDevice(), mSwapchain, VK_NULL_HANDLE);
+  if (mSwapchain) {
+    mContext->forgetPresents(mSwapchain);
+    vkDestroySwapchainKHR(mContext->getDevice(), mSwapchain, VK_NULL_HANDLE);
+  }
+  mPresentId = 0;
+}
+
+void Window::retireSwapchain() {
+  RetiredSwapchain retired{};
+  // Images of the old swapchain may still be queued for presentation, waiting on its semaphores
+  retired.frame        = mContext->getFrameIndex() + Context::MAX_FRAMES_IN_FLIGHT + mImageCount;
+  retired.swapchain    = mSwapchain;
+  retired.imageViews   = std::move(mImageViews);
+  retired.framebuffers = std::move(mFramebuffers);
+  retired.semaphores   = std::move(mSubmitSemaphores);
+  retired.semaphores.insert(retired.semaphores.end(), mImageSemaphores.begin(), mImageSemaphores.end());
+  mRetired.push_back(std::move(retired));
+
+  mContext->forgetPresents(mSwapchain);
+  mSwapchain = VK_NULL_HANDLE;
+  mPresentId = 0;
+  mImageSemaphores.fill(VK_NULL_HANDLE);
+  mImageViews.clear();
+  mFramebuffers.clear();
+  mSubmitSemaphores.clear();
+  mImages.clear();
 }
 
 bool Window::recreateSwapchain() {
   auto [width, height] = getSize();
   if (width == 0 || height == 0) return false;
 
-  cleanupSwapchain();
-  createSwapchain();
+  createSwapchain(mSwapchain);
+  ++mContext->getCurrentStats().swapchainRecreations;
 
   return true;
 }
 
+void Window::destroyRetired(bool all) {
+  auto done = [this, all](const RetiredSwapchain &retired) {
+    if (!all && mContext->getFrameIndex() <= retired.frame) return false;
+
+    VkDevice device = mContext->getDevice();
+    for (VkSemaphore semaphore : retired.semaphores) vkDestroySemaphore(device, semaphore, VK_NULL_HANDLE);
+    for (VkFramebuffer framebuffer : retired.framebuffers) vkDestroyFramebuffer(device, framebuffer, VK_NULL_HANDLE);
+    for (VkImageView imageView : retired.imageViews) vkDestroyImageView(device, imageView, VK_NULL_HANDLE);
+    vkDestroySwapchainKHR(device, retired.swapchain, VK_NULL_HANDLE);
+    return true;
+  };
+
+  mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), done), mRetired.end());
+}
+
 } // namespace purrr::vulkan
 
 #endif // _PURRR_BACKEND_VULKAN
\ No newline at end of file
@@ -9,21 +9,23 @@ namespace purrr::platform {
 inline namespace win32 {
 
   Context::Context(const ContextInfo &info) {
-    (void)info;
+    assert(QueryPerformanceFrequency(reinterpret_cast<LARGE_INTEGER *>(&mTimerFrequency)));
+    double start = getTime();
+
     GetModuleHandleExW(
         GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
         reinterpret_cast<LPCWSTR>(this),
         &mInstance);
 
-    registerClass();
-
-    assert(QueryPerformanceFrequency(reinterpret_cast<LARGE_INTEGER *>(&mTimerFrequency)));
+    if (!info.headless) registerClass();
 
     fillKeyCodeTable();
+
+    mStartupTime = getTime() - start;
   }
 
   Context::~Context() {
-    UnregisterClassW(MAKEINTATOM(mWindowClass), mInstance);
+    if (mWindowClass != INVALID_ATOM) UnregisterClassW(MAKEINTATOM(mWindowClass), mInstance);
   }
 
   void Context::pollWindowEvents() const {
@@ -188,6 +190,7 @@ inline namespace win32 {
   }
 
   void Context::appendRequiredVulkanExtensions(std::vector<const char *> &extensions) {
+    if (mWindowClass == INVALID_ATOM) return;
     extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
     extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
   }
@@ -3,8 +3,12 @@
 #include "purrr/x11/context.hpp"
 #include "purrr/x11/window.hpp"
 
+#include <algorithm>
 #include <cassert>
-#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
 
 #include <X11/XKBlib.h>
 
@@ -12,22 +16,32 @@ namespace purrr::platform {
 inline namespace x11 {
 
   Context::Context(const ContextInfo &info) {
-    (void)info;
+    if (info.headless) return;
+    double start = getTime();
+
     mDisplay = ::XOpenDisplay(nullptr);
+    if (!mDisplay) throw std::runtime_error("Failed to open the X display");
     mContext = XUniqueContext();
-    fillKeyCodeTable();
 
-    aWmProtocols  = ::XInternAtom(mDisplay, "WM_PROTOCOLS", False);
-    aDeleteWindow = ::XInternAtom(mDisplay, "WM_DELETE_WINDOW", False);
-    aNetWmName    = ::XInternAtom(mDisplay, "_NET_WM_NAME", False);
-    aUtf8String   = ::XInternAtom(mDisplay, "UTF8_STRING", False);
+    // One round trip instead of one per atom
+    const char *names[] = { "WM_PROTOCOLS", "WM_DELETE_WINDOW", "_NET_WM_NAME", "UTF8_STRING" };
+    XAtom       atoms[4] = {};
+    ::XInternAtoms(mDisplay, const_cast<char **>(names), 4, False, atoms);
+    aWmProtocols  = atoms[0];
+    aDeleteWindow = atoms[1];
+    aNetWmName    = atoms[2];
+    aUtf8String   = atoms[3];
+
+    mStartupTime = getTime() - start;
   }
 
   Context::~Context() {
-    ::XCloseDisplay(mDisplay);
+    if (mDisplay) ::XCloseDisplay(mDisplay);
   }
 
   void Context::pollWindowEvents() const {
+    if (!mDisplay) return;
+
     ::XEvent event = {};
     while (::XPending(mDisplay) > 0) {
       ::XNextEvent(mDisplay, &event);
@@ -38,6 +52,8 @@ inline namespace x11 {
   }
 
   void Context::waitForWindowEvents() const {
+    if (!mDisplay) return;
+
     ::XEvent event = {};
     do {
       ::XNextEvent(mDisplay, &event);
@@ -48,164 +64,184 @@ inline namespace x11 {
   }
 
   double Context::getTime() const {
-    return 0.0f;
+    ::timespec time = {};
+    ::clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
   }
 
-  void Context::fillKeyCodeTable() {
+  // Key names are at most XkbKeyNameLength characters, packed they can be compared and hashed as integers
+  static uint32_t packKeyName(const char *name) {
+    uint32_t packed = 0;
+    for (int i = 0; i < XkbKeyNameLength && name[i]; ++i)
+      packed |= static_cast<uint32_t>(static_cast<unsigned char>(name[i])) << (i * 8);
+    return packed;
+  }
+
+  void Context::fillKeyCodeTable() const {
+    static const std::pair<KeyCode, const char *> keymap[] = { { KeyCode::GraveAccent, "TLDE" },
+                                                               { KeyCode::N1, "AE01" },
+                                                               { KeyCode::N2, "AE02" },
+                                                               { KeyCode::N3, "AE03" },
+                                                               { KeyCode::N4, "AE04" },
+                                                               { KeyCode::N5, "AE05" },
+                                                               { KeyCode::N6, "AE06" },
+                                                               { KeyCode::N7, "AE07" },
+                                                               { KeyCode::N8, "AE08" },
+                                                               { KeyCode::N9, "AE09" },
+                                                               { KeyCode::N0, "AE10" },
+                                                               { KeyCode::Minus, "AE11" },
+                                                               { KeyCode::Equal, "AE12" },
+                                                               { KeyCode::Q, "AD01" },
+                                                               { KeyCode::W, "AD02" },
+                                                               { KeyCode::E, "AD03" },
+                                                               { KeyCode::R, "AD04" },
+                                                               { KeyCode::T, "AD05" },
+                                                               { KeyCode::Y, "AD06" },
+                                                               { KeyCode::U, "AD07" },
+                                                               { KeyCode::I, "AD08" },
+                                                               { KeyCode::O, "AD09" },
+                                                               { KeyCode::P, "AD10" },
+                                                               { KeyCode::LeftBracket, "AD11" },
+                                                               { KeyCode::RightBracket, "AD12" },
+                                                               { KeyCode::A, "AC01" },
+                                                               { KeyCode::S, "AC02" },
+                                                               { KeyCode::D, "AC03" },
+                                                               { KeyCode::F, "AC04" },
+                                                               { KeyCode::G, "AC05" },
+                                                               { KeyCode::H, "AC06" },
+                                                               { KeyCode::J, "AC07" },
+                                                               { KeyCode::K, "AC08" },
+                                                               { KeyCode::L, "AC09" },
+                                                               { KeyCode::Semicolon, "AC10" },
+                                                               { KeyCode::Apostrophe, "AC11" },
+                                                               { KeyCode::Z, "AB01" },
+                                                               { KeyCode::X, "AB02" },
+                                                               { KeyCode::C, "AB03" },
+                                                               { KeyCode::V, "AB04" },
+                                                               { KeyCode::B, "AB05" },
+                                                               { KeyCode::N, "AB06" },
+                                                               { KeyCode::M, "AB07" },
+                                                               { KeyCode::Comma, "AB08" },
+                                                               { KeyCode::Period, "AB09" },
+                                                               { KeyCode::Slash, "AB10" },
+                                                               { KeyCode::Backslash, "BKSL" },
+                                                               { KeyCode::World1, "LSGT" },
+                                                               { KeyCode::Space, "SPCE" },
+                                                               { KeyCode::Escape, "ESC" },
+                                                               { KeyCode::Enter, "RTRN" },
+                                                               { KeyCode::Tab, "TAB" },
+                                                               { KeyCode::Backspace, "BKSP" },
+                                                               { KeyCode::Insert, "INS" },
+                                                               { KeyCode::Delete, "DELE" },
+                                                               { KeyCode::Right, "RGHT" },
+                                                               { KeyCode::Left, "LEFT" },
+                                                               { KeyCode::Down, "DOWN" },
+                                                               { KeyCode::Up, "UP" },
+                                                               { KeyCode::PageUp, "PGUP" },
+                                                               { KeyCode::PageDown, "PGDN" },
+                                                               { KeyCode::Home, "HOME" },
+                                                               { KeyCode::End, "END" },
+                                                               { KeyCode::CapsLock, "CAPS" },
+                                                               { KeyCode::ScrollLock, "SCLK" },
+                                                               { KeyCode::NumLock, "NMLK" },
+                                                               { KeyCode::PrintScreen, "PRSC" },
+                                                               { KeyCode::Pause, "PAUS" },
+                                                               { KeyCode::F1, "FK01" },
+                                                               { KeyCode::F2, "FK02" },
+                                                               { KeyCode::F3, "FK03" },
+                                                               { KeyCode::F4, "FK04" },
+                                                               { KeyCode::F5, "FK05" },
+                                                               { KeyCode::F6, "FK06" },
+                                                               { KeyCode::F7, "FK07" },
+                                                               { KeyCode::F8, "FK08" },
+                                                               { KeyCode::F9, "FK09" },
+                                                               { KeyCode::F10, "FK10" },
+                                                               { KeyCode::F11, "FK11" },
+                                                               { KeyCode::F12, "FK12" },
+                                                               { KeyCode::F13, "FK13" },
+                                                               { KeyCode::F14, "FK14" },
+                                                               { KeyCode::F15, "FK15" },
+                                                               { KeyCode::F16, "FK16" },
+                                                               { KeyCode::F17, "FK17" },
+                                                               { KeyCode::F18, "FK18" },
+                                                               { KeyCode::F19, "FK19" },
+                                                               { KeyCode::F20, "FK20" },
+                                                               { KeyCode::F21, "FK21" },
+                                                               { KeyCode::F22, "FK22" },
+                                                               { KeyCode::F23, "FK23" },
+                                                               { KeyCode::F24, "FK24" },
+                                                               { KeyCode::F25, "FK25" },
+                                                               { KeyCode::Kp0, "KP0" },
+                                                               { KeyCode::Kp1, "KP1" },
+                                                               { KeyCode::Kp2, "KP2" },
+                                                               { KeyCode::Kp3, "KP3" },
+                                                               { KeyCode::Kp4, "KP4" },
+                                                               { KeyCode::Kp5, "KP5" },
+                                                               { KeyCode::Kp6, "KP6" },
+                                                               { KeyCode::Kp7, "KP7" },
+                                                               { KeyCode::Kp8, "KP8" },
+                                                               { KeyCode::Kp9, "KP9" },
+                                                               { KeyCode::KpDecimal, "KPDL" },
+                                                               { KeyCode::KpDivide, "KPDV" },
+                                                               { KeyCode::KpMultiply, "KPMU" },
+                                                               { KeyCode::KpSubtract, "KPSU" },
+                                                               { KeyCode::KpAdd, "KPAD" },
+                                                               { KeyCode::KpEnter, "KPEN" },
+                                                               { KeyCode::KpEqual, "KPEQ" },
+                                                               { KeyCode::LeftShift, "LFSH" },
+                                                               { KeyCode::LeftControl, "LCTL" },
+                                                               { KeyCode::LeftAlt, "LALT" },
+                                                               { KeyCode::LeftSuper, "LWIN" },
+                                                               { KeyCode::RightShift, "RTSH" },
+                                                               { KeyCode::RightControl, "RCTL" },
+                                                               { KeyCode::RightAlt, "RALT" },
+                                                               { KeyCode::RightAlt, "LVL3" },
+                                                               { KeyCode::RightAlt, "MDSW" },
+                                                               { KeyCode::RightSuper, "RWIN" },
+                                                               { KeyCode::Menu, "MENU" } };
+
+    static const std::unordered_map<uint32_t, KeyCode> keyNames = [] {
+      std::unordered_map<uint32_t, KeyCode> keyNames{};
+      for (const auto &[key, name] : keymap) keyNames.emplace(packKeyName(name), key);
+      return keyNames;
+    }();
+
     XkbDescPtr desc = ::XkbGetMap(mDisplay, 0, XkbUseCoreKbd);
     ::XkbGetNames(mDisplay, XkbKeyNamesMask | XkbKeyAliasesMask, desc);
 
-    std::pair<KeyCode, const char *> keymap[] = { { KeyCode::GraveAccent, "TLDE" },
-                                                  { KeyCode::N1, "AE01" },
-                                                  { KeyCode::N2, "AE02" },
-                                                  { KeyCode::N3, "AE03" },
-                                                  { KeyCode::N4, "AE04" },
-                                                  { KeyCode::N5, "AE05" },
-                                                  { KeyCode::N6, "AE06" },
-                                                  { KeyCode::N7, "AE07" },
-                                                  { KeyCode::N8, "AE08" },
-                                                  { KeyCode::N9, "AE09" },
-                                                  { KeyCode::N0, "AE10" },
-                                                  { KeyCode::Minus, "AE11" },
-                                                  { KeyCode::Equal, "AE12" },
-                                                  { KeyCode::Q, "AD01" },
-                                                  { KeyCode::W, "AD02" },
-                                                  { KeyCode::E, "AD03" },
-                                                  { KeyCode::R, "AD04" },
-                                                  { KeyCode::T, "AD05" },
-                                                  { KeyCode::Y, "AD06" },
-                                                  { KeyCode::U, "AD07" },
-                                                  { KeyCode::I, "AD08" },
-                                                  { KeyCode::O, "AD09" },
-                                                  { KeyCode::P, "AD10" },
-                                                  { KeyCode::LeftBracket, "AD11" },
-                                                  { KeyCode::RightBracket, "AD12" },
-                                                  { KeyCode::A, "AC01" },
-                                                  { KeyCode::S, "AC02" },
-                                                  { KeyCode::D, "AC03" },
-                                                  { KeyCode::F, "AC04" },
-                                                  { KeyCode::G, "AC05" },
-                                                  { KeyCode::H, "AC06" },
-                                                  { KeyCode::J, "AC07" },
-                                                  { KeyCode::K, "AC08" },
-                                                  { KeyCode::L, "AC09" },
-                                                  { KeyCode::Semicolon, "AC10" },
-                                                  { KeyCode::Apostrophe, "AC11" },
-                                                  { KeyCode::Z, "AB01" },
-                                                  { KeyCode::X, "AB02" },
-                                                  { KeyCode::C, "AB03" },
-                                                  { KeyCode::V, "AB04" },
-                                                  { KeyCode::B, "AB05" },
-                                                  { KeyCode::N, "AB06" },
-                                                  { KeyCode::M, "AB07" },
-                                                  { KeyCode::Comma, "AB08" },
-                                                  { KeyCode::Period, "AB09" },
-                                                  { KeyCode::Slash, "AB10" },
-                                                  { KeyCode::Backslash, "BKSL" },
-                                                  { KeyCode::World1, "LSGT" },
-                                                  { KeyCode::Space, "SPCE" },
-                                                  { KeyCode::Escape, "ESC" },
-                                                  { KeyCode::Enter, "RTRN" },
-                                                  { KeyCode::Tab, "TAB" },
-                                                  { KeyCode::Backspace, "BKSP" },
-                                                  { KeyCode::Insert, "INS" },
-                                                  { KeyCode::Delete, "DELE" },
-                                                  { KeyCode::Right, "RGHT" },
-                                                  { KeyCode::Left, "LEFT" },
-                                                  { KeyCode::Down, "DOWN" },
-                                                  { KeyCode::Up, "UP" },
-                                                  { KeyCode::PageUp, "PGUP" },
-                                                  { KeyCode::PageDown, "PGDN" },
-                                                  { KeyCode::Home, "HOME" },
-                                                  { KeyCode::End, "END" },
-                                                  { KeyCode::CapsLock, "CAPS" },
-                                                  { KeyCode::ScrollLock, "SCLK" },
-                                                  { KeyCode::NumLock, "NMLK" },
-                                                  { KeyCode::PrintScreen, "PRSC" },
-                                                  { KeyCode::Pause, "PAUS" },
-                                                  { KeyCode::F1, "FK01" },
-                                                  { KeyCode::F2, "FK02" },
-                                                  { KeyCode::F3, "FK03" },
-                                                  { KeyCode::F4, "FK04" },
-                                                  { KeyCode::F5, "FK05" },
-                                                  { KeyCode::F6, "FK06" },
-                                                  { KeyCode::F7, "FK07" },
-                                                  { KeyCode::F8, "FK08" },
-                                                  { KeyCode::F9, "FK09" },
-                                                  { KeyCode::F10, "FK10" },
-                                                  { KeyCode::F11, "FK11" },
-                                                  { KeyCode::F12, "FK12" },
-                                                  { KeyCode::F13, "FK13" },
-                                                  { KeyCode::F14, "FK14" },
-                                                  { KeyCode::F15, "FK15" },
-                                                  { KeyCode::F16, "FK16" },
-                                                  { KeyCode::F17, "FK17" },
-                                                  { KeyCode::F18, "FK18" },
-                                                  { KeyCode::F19, "FK19" },
-                                                  { KeyCode::F20, "FK20" },
-                                                  { KeyCode::F21, "FK21" },
-                                                  { KeyCode::F22, "FK22" },
-                                                  { KeyCode::F23, "FK23" },
-                                                  { KeyCode::F24, "FK24" },
-                                                  { KeyCode::F25, "FK25" },
-                                                  { KeyCode::Kp0, "KP0" },
-                                                  { KeyCode::Kp1, "KP1" },
-                                                  { KeyCode::Kp2, "KP2" },
-                                                  { KeyCode::Kp3, "KP3" },
-                                                  { KeyCode::Kp4, "KP4" },
-                                                  { KeyCode::Kp5, "KP5" },
-                                                  { KeyCode::Kp6, "KP6" },
-                                                  { KeyCode::Kp7, "KP7" },
-                                                  { KeyCode::Kp8, "KP8" },
-                                                  { KeyCode::Kp9, "KP9" },
-                                                  { KeyCode::KpDecimal, "KPDL" },
-                                                  { KeyCode::KpDivide, "KPDV" },
-                                                  { KeyCode::KpMultiply, "KPMU" },
-                                                  { KeyCode::KpSubtract, "KPSU" },
-                                                  { KeyCode::KpAdd, "KPAD" },
-                                                  { KeyCode::KpEnter, "KPEN" },
-                                                  { KeyCode::KpEqual, "KPEQ" },
-                                                  { KeyCode::LeftShift, "LFSH" },
-                                                  { KeyCode::LeftControl, "LCTL" },
-                                                  { KeyCode::LeftAlt, "LALT" },
-                                                  { KeyCode::LeftSuper, "LWIN" },
-                                                  { KeyCode::RightShift, "RTSH" },
-                                                  { KeyCode::RightControl, "RCTL" },
-                                                  { KeyCode::RightAlt, "RALT" },
-                                                  { KeyCode::RightAlt, "LVL3" },
-                                                  { KeyCode::RightAlt, "MDSW" },
-                                                  { KeyCode::RightSuper, "RWIN" },
-                                                  { KeyCode::Menu, "MENU" } };
+    std::fill(std::begin(mKeyCodes), std::end(mKeyCodes), KeyCode::Count);
 
+    // Keys with unknown names may still have a known alias
+    std::unordered_map<uint32_t, uint16_t> unresolved{};
     for (uint16_t scancode = desc->min_key_code; scancode <= desc->max_key_code; ++scancode) {
-      KeyCode key = KeyCode::Count;
-
-      for (size_t i = 0; i < sizeof(keymap) / sizeof(keymap[0]); i++) {
-        if (std::strncmp(desc->names->keys[scancode].name, keymap[i].second, XkbKeyNameLength) == 0) {
-          key = keymap[i].first;
-          break;
-        }
-      }
+      uint32_t name = packKeyName(desc->names->keys[scancode].name);
+      auto     key  = keyNames.find(name);
+      if (key != keyNames.end())
+        mKeyCodes[scancode] = key->second;
+      else
+        unresolved.emplace(name, scancode);
+    }
 
-      for (int i = 0; i < desc->names->num_key_aliases; i++) {
-        if (key != KeyCode::Count) break;
+    for (int i = 0; i < desc->names->num_key_aliases && !unresolved.empty(); i++) {
+      auto key = keyNames.find(packKeyName(desc->names->key_aliases[i].alias));
+      if (key == keyNames.end()) continue;
 
-        if (std::strncmp(desc->names->key_aliases[i].real, desc->names->keys[scancode].name, XkbKeyNameLength) != 0)
-          continue;
+      auto real = unresolved.find(packKeyName(desc->names->key_aliases[i].real));
+      if (real == unresolved.end()) continue;
 
-        for (size_t j = 0; j < sizeof(keymap) / sizeof(keymap[0]); j++) {
-          if (std::strncmp(desc->names->key_aliases[i].alias, keymap[j].second, XkbKeyNameLength) == 0) {
-            key = keymap[j].first;
-            break;
-          }
-        }
-      }
-
-      mKeyCodes[scancode] = key;
+      mKeyCodes[real->second] = key->second;
+      unresolved.erase(real); // The first alias wins
     }
 
     ::XkbFreeNames(desc, XkbKeyNamesMask, True);
     ::XkbFreeKeyboard(desc, 0, True);
+
+    mKeyCodesFilled = true;
+  }
+
+  KeyCode Context::getKeyCode(uint32_t keycode) const {
+    if (!mKeyCodesFilled) fillKeyCodeTable();
+    return mKeyCodes[keycode];
   }
 
   void Context::handleEvent(::XEvent event) const {
@@ -239,11 +275,11 @@ inline namespace x11 {
       }
     } break;
     case KeyPress: {
-      const KeyCode key = mKeyCodes[keycode];
+      const KeyCode key = getKeyCode(keycode);
       window->inputKey(key, true);
     } break;
     case KeyRelease: {
-      const KeyCode key = mKeyCodes[keycode];
+      const KeyCode key = getKeyCode(keycode);
 
       if (::XEventsQueued(mDisplay, QueuedAfterReading)) {
         ::XEvent next = {};
@@ -306,6 +342,7 @@ inline namespace x11 {
 
 #ifdef _PURRR_BACKEND_VULKAN
   void Context::appendRequiredVulkanExtensions(std::vector<const char *> &extensions) {
+    if (!mDisplay) return;
     extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
     extensions.push_back(VK_KHR_XLIB_SURFACE_EXTENSION_NAME);
   }